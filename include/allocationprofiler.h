@@ -0,0 +1,136 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include "std_defines.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "fastdatapool.hpp"
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#	define CALLER_ADDRESS()	_ReturnAddress()
+#else
+#	define CALLER_ADDRESS()	__builtin_return_address(0)
+#endif
+
+// =================================================================================================
+// Sampling heap profiler. Every n-th allocation of each thread is recorded with its size and
+// call site in a lock-free ring buffer; releases of sampled blocks are recorded, too.
+// Allocations that are not sampled cost a thread local countdown. The ring buffer is drained into
+// statistics keyed by a hash of the call site when it fills up and when a report is written.
+// The live bytes of each call site are estimated from its sampled allocations still alive.
+// On POSIX systems, a report can be requested with SIGUSR2; it is written by the next sampled
+// allocation, since signal handlers cannot do file I/O.
+
+class AllocationSample {
+public:
+	uintptr_t	address;	// address of the sampled block
+	uintptr_t	caller;		// return address of the allocation; 0 if the block was released
+	uint32_t	size;
+};
+
+
+class AllocationSite {
+public:
+	uintptr_t	caller;			// return address of the first allocation sampled at this site
+	uint64_t	sampleCount;
+	uint64_t	sampledBytes;
+	int64_t		liveCount;		// sampled allocations not released yet
+	int64_t		liveBytes;
+
+	AllocationSite()
+		: caller(0), sampleCount(0), sampledBytes(0), liveCount(0), liveBytes(0)
+	{ }
+};
+
+
+class AllocationProfiler {
+private:
+	// Slots of a bounded multi producer ring buffer (D. Vyukov). A slot's sequence tells producers
+	// whether it is free for position pos (sequence == pos) and the consumer whether it has been
+	// filled (sequence == pos + 1).
+	class Slot {
+	public:
+		std::atomic<uint32_t>	sequence;
+		AllocationSample		sample;
+	};
+
+	Slot*					m_slots = nullptr;
+	uint32_t				m_slotMask = 0;
+	std::atomic<uint32_t>	m_tail = 0;			// next position producers write to
+	uint32_t				m_head = 0;			// next position the consumer reads; guarded by m_lock
+	std::atomic<int32_t>	m_sampleInterval = 0;
+	std::atomic<uint64_t>	m_droppedSamples = 0;
+
+	std::mutex				m_lock;				// guards draining and the statistics below
+	FastDataPool<uint32_t, AllocationSite>		m_sites;
+	FastDataPool<uintptr_t, AllocationSample>	m_liveSamples;
+	uint64_t				m_untrackedSamples = 0;	// sampled allocations m_liveSamples had no room for
+	char					m_reportPath[256] = "";
+
+	static thread_local int32_t	m_countdown;
+	static std::atomic<bool>	m_reportRequested;
+
+public:
+	~AllocationProfiler() {
+		Destroy();
+	}
+
+	// sample every sampleInterval-th allocation; ringSize is rounded up to a power of two
+	bool Create(int32_t sampleInterval, int32_t ringSize = 4096, int32_t siteCapacity = 4096, int32_t liveCapacity = 65536);
+
+	void Destroy(void);
+
+	inline bool IsActive(void) const {
+		return m_sampleInterval.load(std::memory_order_relaxed) > 0;
+	}
+
+	inline int32_t SampleInterval(void) const {
+		return m_sampleInterval.load(std::memory_order_relaxed);
+	}
+
+	// decide whether the calling thread's current allocation is sampled
+	inline bool Sample(void) {
+		int32_t interval = m_sampleInterval.load(std::memory_order_relaxed);
+		if ((interval <= 0) or (--m_countdown > 0))
+			return false;
+		m_countdown = interval;
+		return true;
+	}
+
+	static inline uint32_t SiteHash(void* caller) {
+		uint64_t h = uint64_t(uintptr_t(caller)) * 0x9E3779B97F4A7C15ull;
+		uint32_t site = uint32_t(h >> 32);
+		return site ? site : 1;
+	}
+
+	void RecordAlloc(void* address, uint32_t size, void* caller);
+
+	void RecordFree(void* address);
+
+	// write a CSV report of all call sites; the estimated live bytes are scaled by the sample interval
+	bool Report(FILE* stream);
+
+	bool Report(const char* path);
+
+	// request a report to reportPath on SIGUSR2 (POSIX only)
+	bool InstallSignalHandler(const char* reportPath);
+
+	static void SignalHandler(int);
+
+private:
+	bool Push(const AllocationSample& sample);
+
+	void Drain(void);
+
+	void TryDrain(void);
+};
+
+// =================================================================================================
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include "std_defines.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================================================
+// Backing memory of the MemoryManager arena. The arena is mapped directly from the operating
+// system. On request, it uses huge pages to cut TLB misses of large pools:
+// - Linux: explicit huge pages (MAP_HUGETLB), else regular pages with transparent huge pages
+//   requested through madvise(MADV_HUGEPAGE).
+// - Windows: large pages (MEM_LARGE_PAGES, needs the lock pages in memory privilege), else
+//   regular pages.
+// If mapping fails altogether, the arena falls back to malloc.
+// Regular pages are only reserved as address space at first and committed in chunks of
+// commitSize bytes as the arena grows, so resident memory tracks the memory actually used.
+// Chunks lying completely in free memory are decommitted again; their contents are discarded
+// and the pages are faulted in again, zero filled, when that memory is used again.
+// Huge (large) pages cannot be committed lazily and are committed when the arena is created, so
+// they are off by default.
+// Optionally, the arena is bound to a NUMA node, e.g. the node of the thread creating it, or each
+// slab and large block is bound to the node of the thread claiming it from the arena.
+
+#define NUMA_NO_NODE		-1	// no NUMA placement
+#define NUMA_LOCAL_NODE		-2	// node of the thread creating the arena
+#define NUMA_THREAD_NODES	-3	// node of the thread claiming memory from the arena
+
+class ArenaOptions {
+public:
+	size_t	arenaSize;		// address space reserved for the arena
+	bool	useHugePages;
+	int		numaNode;		// NUMA node to bind the arena to, or one of the NUMA_ placement policies
+	size_t	commitSize;		// granularity of committing and decommitting arena memory
+
+	ArenaOptions(size_t _arenaSize = 1000 * 1000 * 1000, bool _useHugePages = false, int _numaNode = NUMA_NO_NODE, size_t _commitSize = 2 * 1024 * 1024)
+		: arenaSize(_arenaSize), useHugePages(_useHugePages), numaNode(_numaNode), commitSize(_commitSize)
+	{ }
+};
+
+
+class ArenaMemory {
+public:
+	using Address = char*;
+
+	enum class Backing : uint8_t {
+		None,
+		Heap,				// malloc fallback
+		Pages,				// regular pages
+		TransparentHugePages,	// regular pages with huge pages requested
+		HugePages			// explicit huge (large) pages
+	};
+
+	Address	m_address = nullptr;
+	size_t	m_size = 0;
+	size_t	m_committed = 0;	// size of the accessible part at the start of the arena; includes decommitted chunks
+	size_t	m_commitSize = 0;
+	size_t	m_pageSize = 0;
+	int		m_numaNode = NUMA_NO_NODE;	// node the arena is bound to, NUMA_THREAD_NODES or NUMA_NO_NODE
+	Backing	m_backing = Backing::None;
+
+	bool Create(const ArenaOptions& options);
+
+	void Destroy(void);
+
+	inline Address GetAddress(void) const {
+		return m_address;
+	}
+
+	inline size_t Size(void) const {
+		return m_size;
+	}
+
+	const char* BackingName(void) const;
+
+	// make the arena accessible up to end
+	inline bool Commit(Address end) {
+		return (end <= m_address + m_committed) or CommitRange(end);
+	}
+
+	// discard the contents of all commit chunks lying completely within [start, end)
+	void Decommit(Address start, Address end);
+
+	// the most arena memory that has been committed; decommitted chunks are not subtracted, since
+	// they are faulted in again by being touched rather than by committing them
+	inline size_t CommittedHighWater(void) const {
+		return m_committed;
+	}
+
+	// NUMA node of the processor the calling thread runs on; 0 if it cannot be determined
+	static int CurrentNumaNode(void);
+
+	// prefer placing the pages lying completely within [address, address + size) on node
+	static bool BindToNode(Address address, size_t size, int node);
+
+	// bind memory just claimed from the arena to the calling thread's node if the arena is set up for it
+	inline void Place(Address address, size_t size) {
+		if (m_numaNode == NUMA_THREAD_NODES)
+			BindToNode(address, size, CurrentNumaNode());
+	}
+
+private:
+	bool Map(size_t size, bool useHugePages, int numaNode);
+
+	bool CommitRange(Address end);
+
+	void DiscardRange(Address start, size_t size);
+};
+
+// =================================================================================================
@@ -81,7 +81,7 @@ public:
         }
         else {
             balance = AVL_OVERFLOW;
-            right->balance = AVL_UNDERFLOW;
+            child->balance = AVL_UNDERFLOW;
         }
         return child;
     }
@@ -140,7 +140,7 @@ public:
     inline AVLNodePtr BalanceLeftShrink(bool& heightHasChanged)
     {
         char b = right->balance;
-        if (b != AVL_BALANCED)
+        if (b == AVL_BALANCED) // a balanced sibling keeps the subtree height after the rotation
             heightHasChanged = false;
         return RotateRight(b != AVL_UNDERFLOW, b != AVL_BALANCED);
     }
@@ -149,7 +149,7 @@ public:
     inline AVLNodePtr BalanceRightShrink(bool& heightHasChanged)
     {
         char b = left->balance;
-        if (b != AVL_BALANCED)
+        if (b == AVL_BALANCED) // a balanced sibling keeps the subtree height after the rotation
             heightHasChanged = false;
         return RotateLeft(b != AVL_OVERFLOW, b != AVL_BALANCED);
     }
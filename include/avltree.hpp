@@ -20,6 +20,7 @@
 
 #include "avltreetraits.h"
 #include "type_helper.hpp"
+#include "monotonicarena.hpp"
 
 #define RELINK_DELETED_NODE 0
 
@@ -71,6 +72,7 @@ private:
 
 private:
     tAVLTreeInfo	        m_info;
+    MonotonicArena*         m_arena = nullptr; // allocate nodes from this arena instead of the heap
 #if DEBUG_MALLOC
     BasicDataPool<AVLNode>  m_nodePool;
     bool                    m_useNodePool;
@@ -106,6 +108,15 @@ inline int Size(void) {
     return m_info.nodeCount;
 }
 
+// Allocate nodes from arena. Only possible while the tree is empty; the tree must not outlive
+// the arena scope its nodes were allocated in.
+bool SetArena(MonotonicArena* arena) {
+    if (m_info.root)
+        return false;
+    m_arena = arena;
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 
 public:
@@ -191,7 +202,9 @@ AVLNodePtr AllocNode(void)
     m_info.workingNode->right = nullptr;
     m_info.workingNode->balance = AVL_BALANCED;
 #else
-    m_info.workingNode = new AVLNode();
+    m_info.workingNode = m_arena ? m_arena->New<AVLNode>() : new AVLNode();
+    if (not m_info.workingNode)
+        return nullptr;
 #endif
     m_info.workingNode->key = std::move(m_info.workingKey);
     m_info.heightHasChanged = true;
@@ -207,6 +220,9 @@ void DeleteNode(AVLNodePtr& node) {
         m_nodePool.Release(node->poolIndex);
     else
 #endif
+    if (m_arena)
+        node->~AVLNode();
+    else
         delete node;
     node = nullptr;
     --m_info.nodeCount;
@@ -494,14 +510,12 @@ private:
         else {
             int rel = m_info.compareNodes(m_info.context, m_info.workingKey, node->key);
             if (rel < 0) {
-                if (not (node->left = RemoveNode(node->left, node)))
-                    return node;
+                node->left = RemoveNode(node->left, node); // an emptied subtree has changed height, too
                 if (m_info.heightHasChanged)
                     node = BalanceLeftShrink(node);
             }
             else if (rel > 0) {
-                if (not (node->right = RemoveNode(node->right, node)))
-                    return node;
+                node->right = RemoveNode(node->right, node); // an emptied subtree has changed height, too
                 if (m_info.heightHasChanged)
                     node =  BalanceRightShrink(node);
             }
@@ -509,6 +523,7 @@ private:
                 m_info.workingParent = parent;
                 m_info.workingNode = node; // node to be deleted
                 m_info.workingData = std::move(node->data);
+                m_info.result = true;
                 if (not node->right) {
                     m_info.heightHasChanged = true;
                     node = node->left;
@@ -555,7 +570,7 @@ public:
         m_info.result = false;
         //AVLTree backup(*this);
         m_info.root = RemoveNode(m_info.root);
-        if (m_info.result)
+        if (not m_info.result)
             return false;
 #if AVL_DEBUG
         if (not CheckForCycles(m_info.root, true))
@@ -5,6 +5,48 @@
 #pragma once
 
 #include <new>
+#include <stdint.h>
+
+// =================================================================================================
+// Generational handle for BasicDataPool items. Index is the item's slot in the pool, generation
+// is the slot's generation at the time the item was claimed. Releasing an item advances the
+// slot's generation, so stale handles no longer resolve instead of aliasing the slot's next
+// occupant. Generation zero is never handed out, so a default constructed handle is invalid.
+
+template <typename ITEM_T>
+class Handle {
+public:
+	uint32_t	m_index;
+	uint32_t	m_generation;
+
+	Handle()
+		: m_index(0), m_generation(0)
+	{ }
+
+	Handle(uint32_t index, uint32_t generation)
+		: m_index(index), m_generation(generation)
+	{ }
+
+	inline uint32_t Index(void) const {
+		return m_index;
+	}
+
+	inline uint32_t Generation(void) const {
+		return m_generation;
+	}
+
+	inline bool IsNull(void) const {
+		return m_generation == 0;
+	}
+
+	inline bool operator== (const Handle& other) const {
+		return (m_index == other.m_index) and (m_generation == other.m_generation);
+	}
+
+	inline bool operator!= (const Handle& other) const {
+		return not (*this == other);
+	}
+};
 
 
 // =================================================================================================
@@ -14,13 +56,14 @@ class BasicDataPool {
 protected:
 	ITEM_T*			m_itemPool;
 	int*			m_freeItems;
+	uint32_t*		m_generations;
 	int				m_capacity;
 	int				m_freeItemCount;
 	bool			m_isCreated;
 
 public:
 	BasicDataPool()
-		: m_itemPool(nullptr), m_freeItems(nullptr), m_capacity(0), m_freeItemCount(0), m_isCreated(false)
+		: m_itemPool(nullptr), m_freeItems(nullptr), m_generations(nullptr), m_capacity(0), m_freeItemCount(0), m_isCreated(false)
 	{
 	}
 
@@ -45,21 +88,20 @@ public:
 
 		m_itemPool = reinterpret_cast<ITEM_T*>(malloc(capacity * sizeof(ITEM_T))); // new DataItem<ITEM_T>[capacity];
 		m_freeItems = reinterpret_cast<int*>(malloc(capacity * sizeof(*m_freeItems))); // new int[capacity];
+		m_generations = reinterpret_cast<uint32_t*>(malloc(capacity * sizeof(*m_generations)));
 
-		if (not (m_itemPool and m_freeItems)) {
+		if (not (m_itemPool and m_freeItems and m_generations)) {
 			Destroy();
 			return false;
 		}
 
-		if constexpr (std::is_trivially_destructible<ITEM_T>::value) {
-			memset(m_itemPool, 0, capacity * sizeof(ITEM_T));
-		}
-		else {
-			for (int i = 0; i < m_capacity; i++)
-				new(m_itemPool + i) ITEM_T();
-		}
+		// value-initialize the items; this zeroes trivial types
 		for (int i = 0; i < capacity; i++)
+			new(m_itemPool + i) ITEM_T();
+		for (int i = 0; i < capacity; i++) {
 			m_freeItems[i] = capacity - i - 1;
+			m_generations[i] = 1;
+		}
 
 		m_capacity =
 		m_freeItemCount = capacity;
@@ -81,6 +123,10 @@ public:
 			free(m_freeItems); // delete[] m_freeItems;
 			m_freeItems = nullptr;
 		}
+		if (m_generations) {
+			free(m_generations);
+			m_generations = nullptr;
+		}
 		m_isCreated = false;
 	}
 
@@ -94,20 +140,57 @@ public:
 #endif
 		//fprintf(stderr, "claiming data pool item #%d\n", i);
 		ITEM_T* item = m_itemPool + itemIndex;
+		// items stay constructed from Setup to Destroy (released items remain readable), so reset
+		// the claimed item by assignment; constructing it again would leak what it owned
 		if constexpr (not std::is_trivially_constructible<ITEM_T>::value) {
-			new(item) ITEM_T();
+			*item = ITEM_T();
 		}
 		//m_freeItems[m_freeItemCount] = -1;
 		return item;
 	}
 
 
+	// claim an item and return a handle to it instead of its raw index
+	ITEM_T* Claim(Handle<ITEM_T>& handle) {
+		int itemIndex;
+		ITEM_T* item = Claim(itemIndex);
+		handle = item ? Handle<ITEM_T>(uint32_t(itemIndex), m_generations[itemIndex]) : Handle<ITEM_T>();
+		return item;
+	}
+
+
 	inline ITEM_T* Release(int itemIndex) {
+		// skip generation zero on wrap around, it marks null handles
+		if (not ++m_generations[itemIndex])
+			m_generations[itemIndex] = 1;
 		m_freeItems[m_freeItemCount++] = itemIndex;
 		return m_itemPool + itemIndex;
 	}
 
 
+	// release the item referenced by handle; stale handles (item already released) are rejected
+	inline ITEM_T* Release(const Handle<ITEM_T>& handle) {
+		return IsValid(handle) ? Release(int(handle.Index())) : nullptr;
+	}
+
+
+	inline bool IsValid(const Handle<ITEM_T>& handle) const {
+		return (handle.Index() < uint32_t(m_capacity)) and (m_generations[handle.Index()] == handle.Generation());
+	}
+
+
+	// O(1) handle resolution; returns nullptr for null and stale handles
+	inline ITEM_T* Resolve(const Handle<ITEM_T>& handle) {
+		return IsValid(handle) ? m_itemPool + handle.Index() : nullptr;
+	}
+
+
+	inline Handle<ITEM_T> GetHandle(ITEM_T* item) {
+		int itemIndex = ItemIndex(item);
+		return Handle<ITEM_T>(uint32_t(itemIndex), m_generations[itemIndex]);
+	}
+
+
 	ITEM_T& operator[](int i) {
 		return this->m_itemPool[i];
 	}
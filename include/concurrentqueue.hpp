@@ -0,0 +1,240 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <stdint.h>
+
+#include "nodepool.hpp"
+
+#define QUEUE_CACHE_LINE_SIZE	64
+
+// =================================================================================================
+// Work queues for passing items between threads, as replacements for a List guarded by a mutex.
+// Like List, items are added with Append and taken from the front with Extract(data, 0).
+//
+// SPSCQueue: bounded ring buffer for exactly one producer and one consumer thread. Append and
+// Extract are wait-free; Append fails when the ring is full.
+//
+// MPSCQueue: unbounded queue for any number of producer threads and one consumer thread
+// (D. Vyukov's intrusive MPSC queue). Producers link a node with a single atomic exchange and
+// never wait for each other. Extract may report the queue empty while a producer is between its
+// exchange and linking the node; the item becomes visible right after.
+
+template <typename ITEM_T>
+class SPSCQueue {
+public:
+	using ItemType = ITEM_T;
+
+private:
+	ItemType*	m_items;
+	uint32_t	m_mask;
+
+	// the producer's and the consumer's positions live on separate cache lines, each with the
+	// owner's cached copy of the other position, so that the threads only share a line when the
+	// cached copy is out of date
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<uint32_t>	m_tail;	// next position to write
+	uint32_t												m_headCache;
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<uint32_t>	m_head;	// next position to read
+	uint32_t												m_tailCache;
+
+public:
+	// capacity is rounded up to a power of two
+	explicit SPSCQueue(int32_t capacity = 1024)
+		: m_tail(0), m_headCache(0), m_head(0), m_tailCache(0)
+	{
+		uint32_t size = 2;
+		while (size < uint32_t(capacity))
+			size <<= 1;
+		m_items = new ItemType[size];
+		m_mask = size - 1;
+	}
+
+	~SPSCQueue() {
+		delete[] m_items;
+	}
+
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+
+	// producer thread only; false if the queue is full
+	template<typename T>
+	bool Append(T&& dataItem) {
+		uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_headCache > m_mask) {
+			m_headCache = m_head.load(std::memory_order_acquire);
+			if (tail - m_headCache > m_mask)
+				return false;
+		}
+		m_items[tail & m_mask] = std::forward<T>(dataItem);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+
+	// consumer thread only; only the first item (i == 0) can be extracted
+	bool Extract(ItemType& data, int i = 0) {
+		if (i != 0)
+			return false;
+		uint32_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tailCache) {
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			if (head == m_tailCache)
+				return false;
+		}
+		data = std::move(m_items[head & m_mask]);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+
+	inline bool IsEmpty(void) const {
+		return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+	}
+
+	inline int32_t Length(void) const {
+		return int32_t(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+	}
+
+	inline int32_t Capacity(void) const {
+		return int32_t(m_mask + 1);
+	}
+};
+
+// =================================================================================================
+
+template <typename ITEM_T>
+class MPSCQueue {
+public:
+	using ItemType = ITEM_T;
+
+	class Node {
+	public:
+		std::atomic<Node*>	m_succ;
+		ItemType			m_dataItem;
+
+		Node()
+			: m_succ(nullptr), m_dataItem()
+		{ }
+
+		template<typename T>
+		explicit Node(T&& dataItem)
+			: m_succ(nullptr), m_dataItem(std::forward<T>(dataItem))
+		{ }
+	};
+
+	using NodePoolType = NodePool<Node>;
+
+private:
+	alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<Node*>	m_tail;	// last node; producers append behind it
+	alignas(QUEUE_CACHE_LINE_SIZE) Node*				m_head;	// node before the first item; consumer only
+	Node			m_stub;
+	Node*			m_released;			// nodes the consumer has extracted, returned to the pool in batches
+	int32_t			m_releasedCount;
+	// NodePool is not thread safe; the lock only guards taking nodes from and returning them to
+	// the pool, never the queue itself
+	std::mutex		m_poolLock;
+	NodePoolType	m_nodePool;
+
+	static constexpr int32_t RELEASE_BATCH_SIZE = 32;
+
+public:
+	MPSCQueue()
+		: m_tail(&m_stub), m_head(&m_stub), m_released(nullptr), m_releasedCount(0)
+	{ }
+
+	~MPSCQueue() {
+		ItemType data;
+		while (Extract(data))
+			;
+		if (m_head != &m_stub)
+			Release(m_head);
+		FlushReleased();
+	}
+
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+
+	// Link a node the caller owns behind the last node; lock-free, any thread.
+	inline void Push(Node* node) {
+		node->m_succ.store(nullptr, std::memory_order_relaxed);
+		Node* pred = m_tail.exchange(node, std::memory_order_acq_rel);
+		pred->m_succ.store(node, std::memory_order_release);
+	}
+
+
+	// Return the node holding the first item; consumer thread only. The node stays the queue's head
+	// until the next Pop hands it back in released; only then may it be reused or freed.
+	// Returns nullptr if the queue is empty.
+	inline Node* Pop(Node*& released) {
+		Node* head = m_head;
+		Node* succ = head->m_succ.load(std::memory_order_acquire);
+		if (not succ)
+			return nullptr;
+		m_head = succ;
+		released = (head == &m_stub) ? nullptr : head;
+		return succ;
+	}
+
+
+	// any thread; false if no node could be allocated
+	template<typename T>
+	bool Append(T&& dataItem) {
+		Node* node;
+		{
+			std::lock_guard<std::mutex> lock(m_poolLock);
+			node = m_nodePool.New(std::forward<T>(dataItem));
+		}
+		if (not node)
+			return false;
+		Push(node);
+		return true;
+	}
+
+
+	// consumer thread only; only the first item (i == 0) can be extracted
+	bool Extract(ItemType& data, int i = 0) {
+		if (i != 0)
+			return false;
+		Node* released;
+		Node* node = Pop(released);
+		if (not node)
+			return false;
+		data = std::move(node->m_dataItem);
+		if (released)
+			Release(released);
+		return true;
+	}
+
+
+	inline bool IsEmpty(void) const {
+		return m_head->m_succ.load(std::memory_order_acquire) == nullptr;
+	}
+
+private:
+	void Release(Node* node) {
+		node->m_succ.store(m_released, std::memory_order_relaxed);
+		m_released = node;
+		if (++m_releasedCount == RELEASE_BATCH_SIZE)
+			FlushReleased();
+	}
+
+
+	void FlushReleased(void) {
+		std::lock_guard<std::mutex> lock(m_poolLock);
+		while (m_released) {
+			Node* node = m_released;
+			m_released = node->m_succ.load(std::memory_order_relaxed);
+			m_nodePool.Delete(node);
+		}
+		m_releasedCount = 0;
+	}
+};
+
+// =================================================================================================
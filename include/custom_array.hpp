@@ -6,8 +6,20 @@
 
 #define NOMINMAX
 
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <type_traits>
+
 #include "sharedpointer.hpp"
 #include "quicksort.hpp"
+#include "relocation.hpp"
+#include "simdkernels.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include "parallelsort.hpp"
+#include "monotonicarena.hpp"
 
 #define sizeofa(_a)	((sizeof(_a) / sizeof(*(_a))))
 
@@ -107,7 +119,6 @@ class ManagedArray
 public:
 	using Base = ArrayBuffer<DATA_T, POINTER_T>;
 	using Base::operator=; // erlaubt Zuweisung über m_handle = ...
-	using Base::IsStatic;
 	using Base::BufferHandle;
 	using HANDLE_T = DATA_T*;
 
@@ -117,7 +128,8 @@ private:
 
 	class ArrayInfo {
 	public:
-		int32_t	capacity;
+		int32_t	capacity;	// elements allocated
+		int32_t	length;		// elements in use
 		int32_t	height;
 		int32_t	width;
 		int32_t	pos;
@@ -127,11 +139,13 @@ private:
 	public:
 
 		ArrayInfo(int32_t _width = 0, int32_t _height = 0, int32_t _offset = 0)
-			: capacity(0), height(_height), width(_width), pos(0), offset(_offset), wrap(false)
+			: capacity(0), length(0), height(_height), width(_width), pos(0), offset(_offset), wrap(false)
 		{
 		}
 
 		inline int32_t Capacity(void) { return capacity; }
+
+		inline int32_t Length(void) { return length; }
 	};
 
 protected:
@@ -139,6 +153,14 @@ protected:
 	ArrayInfo				m_info;
 	//ArrayBuffer<DATA_T	m_handle;
 	DATA_T					m_none;
+	MonotonicArena*			m_arena = nullptr;		// allocate buffers from this arena instead of the heap
+	bool					m_isArenaBuffer = false;
+	bool					m_isRawBuffer = false;	// only the elements in use are constructed (see AllocBuffer)
+	size_t					m_alignment = alignof(DATA_T);		// of buffers allocated from now on (see SetAlignment)
+	size_t					m_rawAlignment = alignof(DATA_T);	// the raw heap buffer was allocated with
+	DATA_T*					m_inlineBuffer = nullptr;	// raw storage inside the array object (see SmallArray)
+	int32_t					m_inlineCapacity = 0;
+	bool					m_isInlineBuffer = false;
 
 	// ----------------------------------------
 
@@ -152,7 +174,7 @@ public:
 	public:
 		explicit Iterator() : m_start(nullptr), m_end(nullptr), m_current(nullptr) {}
 
-		Iterator(ManagedArray& a) : m_start(a.Start()), m_end(a.End() + 1), m_current(nullptr) {}
+		Iterator(ManagedArray& a) : m_start(a.Start()), m_end(a.Start() + a.Length()), m_current(nullptr) {}
 
 		operator bool() const {
 			return m_current != nullptr;
@@ -200,24 +222,25 @@ public:
 		// fprintf(stderr, "%s\n", __FUNCSIG__);
 	}
 
-	explicit ManagedArray(const int32_t capacity)
+	explicit ManagedArray(const int32_t length)
 		: m_info(), m_none(DATA_T())
 	{
 		// fprintf(stderr, "%s\n", __FUNCSIG__);
-		Reserve(capacity);
+		Resize(length);
 	}
 
 	explicit ManagedArray(const int32_t width, const int32_t height)
 		: m_info(width, height), m_none(DATA_T())
 	{
 		// fprintf(stderr, "%s\n", __FUNCSIG__);
-		Reserve(width, height);
+		Reserve(width, height, 0);
 	}
 
 	ManagedArray(ManagedArray const& other)
 		: m_info(), m_none(DATA_T())
 	{
 		// fprintf(stderr, "%s\n", __FUNCSIG__);
+		m_alignment = other.m_alignment;
 		CopyData(other);
 	}
 
@@ -228,19 +251,19 @@ public:
 		Move(other);
 	}
 
-	explicit ManagedArray(DATA_T const* data, int32_t capacity, int32_t offset = 0)
+	explicit ManagedArray(DATA_T const* data, int32_t length, int32_t offset = 0)
 		: m_info(0, 0, offset), m_none(DATA_T())
 	{
 		// fprintf(stderr, "%s\n", __FUNCSIG__);
-		Reserve(capacity);
-		memcpy(Data(), data, sizeof(DATA_T) * capacity);
+		Resize(length);
+		std::copy(data, data + m_info.length, Data());
 	}
 
 	ManagedArray(std::initializer_list<DATA_T> data)
 		: m_info(), m_none(DATA_T())
 	{
 		// fprintf(stderr, "%s\n", __FUNCSIG__);
-		Reserve(int32_t(data.size()));
+		Resize(int32_t(data.size()));
 		int32_t i = 0;
 		for (auto it = data.begin(); it != data.end(); it++)
 			*Data(i++) = *it;
@@ -272,14 +295,13 @@ public:
 		if constexpr (std::is_trivially_constructible<DATA_T>::value)
 			memset(&m_none, 0, sizeof(m_none));
 		else
-			new(&m_none) DATA_T();
+			m_none = DATA_T();
 	}
 
 	// ----------------------------------------
 
 	void Reset(void) {
-		Base::Destroy();
-		m_info.capacity = 0;
+		Destroy();
 		Init(); // leave width and height intact
 	}
 
@@ -287,30 +309,78 @@ public:
 
 	void Clear(uint8_t filler = 0, int32_t count = 0u) {
 		if (Data())
-			memset(Data(), filler, sizeof(DATA_T) * ((count and (count < m_info.capacity)) ? count : m_info.capacity));
+			memset(Data(), filler, sizeof(DATA_T) * ((count and (count < m_info.length)) ? count : m_info.length));
 	}
 
 	// ----------------------------------------
 
 	void Fill(DATA_T filler, int32_t count = -1) {
 		if (Data()) {
-			if (count < 0)
-				count = m_info.capacity;
-			for (DATA_T* bufP = Data(); count; count--, bufP++)
-				*bufP = filler;
+			if ((count < 0) or (count > m_info.length))
+				count = m_info.length;
+			ArrayFill(Data(), count, filler);
 		}
 	}
 
+	// ----------------------------------------
+	// element-wise queries and arithmetic; float, int32_t and uint8_t arrays use the vector kernels
+
+	// index of the first element equal to value, -1 if there is none
+	inline int32_t Find(const DATA_T& value) {
+		return Data() ? ArrayFind(Data(), m_info.length, value) : -1;
+	}
+
+	// ----------------------------------------
+
+	inline int32_t Count(const DATA_T& value) {
+		return Data() ? ArrayCount(Data(), m_info.length, value) : 0;
+	}
+
+	// ----------------------------------------
+
+	inline DATA_T Min(void) {
+		return (Data() and m_info.length) ? ArrayMin(Data(), m_info.length) : m_none;
+	}
+
+	// ----------------------------------------
+
+	inline DATA_T Max(void) {
+		return (Data() and m_info.length) ? ArrayMax(Data(), m_info.length) : m_none;
+	}
+
+	// ----------------------------------------
+
+	inline ArraySumType<DATA_T> Sum(void) {
+		return Data() ? ArraySum(Data(), m_info.length) : ArraySumType<DATA_T>();
+	}
+
+	// ----------------------------------------
+	// this[i] += other[i] for all elements both arrays have
+
+	inline ManagedArray& Add(ManagedArray& other) {
+		if (Data() and other.Data())
+			ArrayAdd(Data(), other.Data(), std::min(m_info.length, other.m_info.length));
+		return *this;
+	}
+
+	// ----------------------------------------
+
+	inline ManagedArray& Mul(ManagedArray& other) {
+		if (Data() and other.Data())
+			ArrayMul(Data(), other.Data(), std::min(m_info.length, other.m_info.length));
+		return *this;
+	}
+
 	// ----------------------------------------
 
 	inline bool IsIndex(int32_t i) {
-		return Data() and (i - m_info.offset >= 0) and (i - m_info.offset < m_info.capacity);
+		return Data() and (i - m_info.offset >= 0) and (i - m_info.offset < m_info.length);
 	}
 
 	// ----------------------------------------
 
 	inline bool IsElement(DATA_T* elem, bool bDiligent = false) {
-		if (not Data() or (elem < Data()) or (elem >= Data() + m_info.capacity))
+		if (not Data() or (elem < Data()) or (elem >= Data() + m_info.length))
 			return false;	// no data or element out of data
 		if (bDiligent) {
 			int32_t i = static_cast<int32_t>(reinterpret_cast<uint8_t*>(elem) - reinterpret_cast<uint8_t*>(Data()));
@@ -335,25 +405,131 @@ public:
 	// ----------------------------------------
 
 	void Destroy(void) {
-		Base::Destroy();
+		ReleaseBuffer();
 		m_info.capacity = 0;
+		m_info.length = 0;
 	}
 
 	// ----------------------------------------
+	// Return the buffer to where it came from; leaves m_info alone.
+
+	void ReleaseBuffer(void) {
+		if (m_isRawBuffer) {
+			DestroyElements(0, m_info.length);
+			if (not (m_isArenaBuffer or m_isInlineBuffer))
+				FreeRaw(Data(), m_rawAlignment);
+			BufferHandle() = nullptr;
+			m_isRawBuffer = false;
+		}
+		else if constexpr (not std::is_trivially_destructible<DATA_T>::value) {
+			// the arena does not run destructors
+			if (m_isArenaBuffer) {
+				for (int32_t i = 0; i < m_info.capacity; i++)
+					Data()[i].~DATA_T();
+			}
+		}
+		m_isArenaBuffer = false;
+		m_isInlineBuffer = false;
+		Base::Destroy();
+	}
 
-	DATA_T* Reserve(int32_t capacity, int32_t offset = 0) {
-		if (m_info.capacity != capacity) {
-			Destroy();
-#if 0
-			Base::Reserve(capacity);
-#else
-			DATA_T* data = new DATA_T[capacity];
-			if (data) {
-				Base::SetBuffer(data, false);
-				m_info.capacity = capacity;
-				Base::m_isStatic = false;
+	// ----------------------------------------
+	// Allocate buffers from arena. Arena buffers are static to ArrayBuffer and are not deleted
+	// by it; the array must not outlive the arena scope they were allocated in.
+
+	inline void SetArena(MonotonicArena* arena) {
+		m_arena = arena;
+	}
+
+	// ----------------------------------------
+
+	inline MonotonicArena* GetArena(void) const {
+		return m_arena;
+	}
+
+	// ----------------------------------------
+	// Align buffers allocated from now on to alignment bytes (a power of two), e.g. to cache lines.
+	// Only applies to buffers held by a plain pointer; the current buffer is left as it is.
+
+	inline void SetAlignment(size_t alignment) {
+		m_alignment = std::max(alignment, alignof(DATA_T));
+	}
+
+	// ----------------------------------------
+	// Buffers held by a plain pointer are raw storage from the heap or the arena; only the elements in
+	// use are constructed in them, and growing relocates the elements (see relocation.hpp).
+	// A SharedPointer deletes its buffer with delete[], so its buffers always hold constructed elements.
+
+	inline DATA_T* AllocBuffer(int32_t capacity) {
+		if ((capacity <= m_inlineCapacity) and (Data() != m_inlineBuffer))
+			return m_inlineBuffer;
+		if constexpr (not std::is_pointer_v<POINTER_T>)
+			return m_arena ? m_arena->NewArray<DATA_T>(size_t(capacity)) : new DATA_T[capacity];
+		else if (m_arena)
+			return reinterpret_cast<DATA_T*>(m_arena->Alloc(size_t(capacity) * sizeof(DATA_T), m_alignment));
+		else
+			return AllocRaw(capacity, m_alignment);
+	}
+
+	// ----------------------------------------
+
+	static inline DATA_T* AllocRaw(int32_t capacity, size_t alignment) {
+		if (alignment > alignof(std::max_align_t))
+			return reinterpret_cast<DATA_T*>(::operator new(size_t(capacity) * sizeof(DATA_T), std::align_val_t(alignment), std::nothrow));
+		else
+			return reinterpret_cast<DATA_T*>(malloc(size_t(capacity) * sizeof(DATA_T)));
+	}
+
+	// ----------------------------------------
+
+	static inline void FreeRaw(DATA_T* p, size_t alignment) {
+		if (alignment > alignof(std::max_align_t))
+			::operator delete(p, std::align_val_t(alignment));
+		else
+			free(p);
+	}
+
+	// ----------------------------------------
+	// Start the life of elements [from, to) of a raw buffer. All elements of other buffers are alive.
+
+	inline void ConstructElements(int32_t from, int32_t to) {
+		if (m_isRawBuffer and (from < to))
+			std::uninitialized_default_construct(Data() + from, Data() + to);
+	}
+
+	// ----------------------------------------
+	// End the life of elements [from, to) of a raw buffer. Elements of other buffers stay alive, but are
+	// reset to default values so that they release their resources.
+
+	inline void DestroyElements(int32_t from, int32_t to) {
+		if constexpr (not std::is_trivially_destructible<DATA_T>::value) {
+			if (m_isRawBuffer)
+				std::destroy(Data() + from, Data() + to);
+			else {
+				for (int32_t i = from; i < to; i++)
+					Data()[i] = DATA_T();
 			}
-#endif
+		}
+	}
+
+	// ----------------------------------------
+	// Capacity to grow to when required elements are needed. Doubling the buffer makes appending
+	// element by element amortized constant time: each element is relocated less than twice on average.
+	// Arrays with inline storage use it as long as the elements fit into it.
+
+	inline int32_t GrowCapacity(int32_t capacity, int32_t required) const {
+		if (required <= m_inlineCapacity)
+			return m_inlineCapacity;
+		int64_t grown = std::max(2 * int64_t(capacity), int64_t(4));
+		return int32_t(std::min(std::max(int64_t(required), grown), int64_t(INT32_MAX)));
+	}
+
+	// ----------------------------------------
+	// Make room for at least capacity elements. Keeps the contents and never shrinks the buffer.
+
+	DATA_T* Reserve(int32_t capacity, int32_t offset = 0) {
+		if (capacity > m_info.capacity) {
+			Realloc(capacity);
 			m_info.offset = offset;
 		}
 		return Data();
@@ -363,7 +539,7 @@ public:
 
 	inline DATA_T* Reserve(int32_t width, int32_t height, int32_t offset = 0) {
 		Init(width, height);
-		Reserve(width * height);
+		Resize(width * height, false);
 		return Data();
 	}
 
@@ -397,48 +573,161 @@ public:
 			else {
 				Base::SetBuffer(data, true);
 				m_info.capacity = capacity;
+				m_info.length = capacity;
 			}
 		}
 	}
 
 	// ----------------------------------------
+	// the buffer does not belong to the array (see SetBuffer)
 
-	inline DATA_T* Realloc(int32_t capacity, bool keepData) {
+	inline bool IsStatic(void) const {
+		return Base::IsStatic() and not m_isRawBuffer;
+	}
+
+	// ----------------------------------------
+	// Move the elements in use to a new buffer of capacity elements. Returns the old buffer if no new
+	// one could be allocated.
+
+	DATA_T* Realloc(int32_t capacity, bool keepData = true) {
+		int32_t length = keepData ? std::min(m_info.length, capacity) : 0;
+		if constexpr (std::is_pointer_v<POINTER_T> and is_trivially_relocatable_v<DATA_T>) {
+			// the heap may be able to grow the buffer in place, and copies the elements otherwise
+			if (m_isRawBuffer and not (m_isArenaBuffer or m_isInlineBuffer) and (length == m_info.length) and (capacity > m_inlineCapacity) and (std::max(m_alignment, m_rawAlignment) <= alignof(std::max_align_t))) {
+				DATA_T* p = reinterpret_cast<DATA_T*>(realloc(static_cast<void*>(Data()), size_t(capacity) * sizeof(DATA_T)));
+				if (not p)
+					return Data();
+				Base::SetBuffer(p, true);
+				m_info.capacity = capacity;
+				return p;
+			}
+		}
 		DATA_T* p;
 		try {
-			p = new DATA_T[capacity];
+			p = AllocBuffer(capacity);
 		}
 		catch (...) {
 			return Data();
 		}
-		if (keepData and Data()) {
-			memcpy(p, Data(), ((capacity > m_info.capacity) ? m_info.capacity : capacity) * sizeof(DATA_T));
-			Clear(); // hack to avoid d'tors
+		if (not p)
+			return Data();
+		if (m_isRawBuffer) {
+			DestroyElements(length, m_info.length);
+			RelocateElements(p, Data(), length);
+			m_info.length = 0; // nothing left to destroy
+		}
+		else if (length) {
+			if constexpr (std::is_pointer_v<POINTER_T>)
+				std::uninitialized_move(Data(), Data() + length, p); // the elements stay with the buffer's owner
+			else
+				std::copy(Data(), Data() + length, p); // other arrays may still use a shared buffer
 		}
-		Base::SetBuffer(p, false);
+		ReleaseBuffer();
+		m_isInlineBuffer = (p == m_inlineBuffer);
+		Base::SetBuffer(p, std::is_pointer_v<POINTER_T> or (m_arena != nullptr) or m_isInlineBuffer);
+		m_isRawBuffer = std::is_pointer_v<POINTER_T> or m_isInlineBuffer;
+		m_isArenaBuffer = (m_arena != nullptr) and not m_isInlineBuffer;
+		m_rawAlignment = m_alignment;
+		m_info.capacity = capacity;
+		m_info.length = length;
 		return p;
 	}
 
+	// ----------------------------------------
+	// Set the number of elements in use. The buffer only grows, geometrically (see GrowCapacity).
+	// Returns nullptr if the buffer could not be grown.
+
+	DATA_T* Resize(int32_t length, bool keepData = true) {
+		if (length > m_info.capacity) {
+			Realloc(GrowCapacity(m_info.capacity, length), keepData);
+			if (length > m_info.capacity)
+				return nullptr;
+		}
+		if (length < m_info.length)
+			DestroyElements(length, m_info.length);
+		else
+			ConstructElements(m_info.length, length);
+		m_info.length = length;
+		m_info.pos = length ? m_info.pos % length : 0;
+		return Data();
+	}
 
-	DATA_T* Resize(int32_t capacity, bool keepData = true) {
-		if (IsStatic())
-			return Reserve(capacity);
-		if (capacity > m_info.capacity) {
-			Realloc(capacity, keepData);
-			m_info.capacity = capacity;
-			m_info.pos %= capacity;
+	// ----------------------------------------
+	// Return unused capacity to the heap. Static, arena and inline buffers are left as they are; heap
+	// buffers whose elements fit into the inline storage are given up for it.
+
+	DATA_T* ShrinkToFit(void) {
+		if ((m_info.length < m_info.capacity) and not (IsStatic() or m_isArenaBuffer or m_isInlineBuffer)) {
+			if (m_info.length)
+				Realloc((m_info.length <= m_inlineCapacity) ? m_inlineCapacity : m_info.length);
+			else
+				Destroy();
 		}
 		return Data();
 	}
 
 	// ----------------------------------------
 
+	template<typename T>
+	DATA_T* Append(T&& data) {
+		if (m_info.length < m_info.capacity)
+			return PlaceBack(std::forward<T>(data));
+		DATA_T h(std::forward<T>(data)); // data may be an element of this array
+		Realloc(GrowCapacity(m_info.capacity, m_info.length + 1));
+		if (m_info.length == m_info.capacity)
+			return nullptr;
+		return PlaceBack(std::move(h));
+	}
+
+	// ----------------------------------------
+
+	ManagedArray& Append(ManagedArray& other, bool copyData) {
+		int32_t l = m_info.length;
+		int32_t n = other.m_info.length;
+		if (n and Resize(l + n)) { // other may be this array
+			if (copyData or (&other == this))
+				std::copy(other.Data(), other.Data() + n, Data() + l);
+			else {
+				std::move(other.Data(), other.Data() + n, Data() + l);
+				other.Resize(0);
+			}
+		}
+		return *this;
+	}
+
+	// ----------------------------------------
+	// put data behind the last element in use; the buffer must have room for it
+
+	template<typename T>
+	inline DATA_T* PlaceBack(T&& data) {
+		DATA_T* p = Data() + m_info.length++;
+		if (m_isRawBuffer)
+			new (p) DATA_T(std::forward<T>(data));
+		else
+			*p = std::forward<T>(data);
+		return p;
+	}
+
+	// ----------------------------------------
+
 	inline const int32_t Capacity(void) const {
 		return m_info.capacity;
 	}
 
 	// ----------------------------------------
 
+	inline int32_t Length(void) const {
+		return m_info.length;
+	}
+
+	// ----------------------------------------
+
+	inline bool IsEmpty(void) const {
+		return m_info.length == 0;
+	}
+
+	// ----------------------------------------
+
 	inline DATA_T* Current(void) {
 		return Data(m_info.pos);
 	}
@@ -446,13 +735,13 @@ public:
 	// ----------------------------------------
 
 	inline int32_t Size(void) {
-		return m_info.capacity * sizeof(DATA_T);
+		return m_info.length * sizeof(DATA_T);
 	}
 
 	// ----------------------------------------
 
 	inline bool IsValidIndex(int32_t i) {
-		return (i >= 0) and (i < m_info.capacity);
+		return (i >= 0) and (i < m_info.length);
 	}
 
 	// ----------------------------------------
@@ -464,7 +753,7 @@ public:
 	// ----------------------------------------
 
 	inline int GetCheckedIndex(int32_t x, int32_t y) {
-		return IsValidIndex(x, y) ? -1 : int(y * m_info.width + x);
+		return IsValidIndex(x, y) ? int(y * m_info.width + x) : -1;
 	}
 
 	// ----------------------------------------
@@ -520,7 +809,7 @@ public:
 	// ----------------------------------------
 
 	inline ManagedArray<DATA_T>& operator= (ManagedArray<DATA_T> const& source) {
-		return CopyData(source.Data(), source.Capacity());
+		return CopyData(source.Data(), source.Length());
 	}
 
 	// ----------------------------------------
@@ -532,9 +821,9 @@ public:
 	// ----------------------------------------
 
 	inline ManagedArray<DATA_T>& operator= (std::initializer_list<DATA_T> data) {
-		Reserve(int32_t(data.size()));
+		Resize(int32_t(data.size()), false);
 		Init();
-		memcpy(Data(), data.begin(), sizeof(DATA_T) * data.size());
+		std::copy(data.begin(), data.end(), Data());
 		return *this;
 	}
 
@@ -542,7 +831,7 @@ public:
 
 	inline DATA_T& operator= (DATA_T* source) {
 		if (this != &source)
-			memcpy(Data(), source, m_info.capacity * sizeof(DATA_T));
+			memcpy(Data(), source, m_info.length * sizeof(DATA_T));
 		return *Data();
 	}
 
@@ -551,11 +840,14 @@ public:
 	ManagedArray& CopyData(const ManagedArray& source, bool allowStatic = true, int32_t offset = 0) {
 		if ((this != &source) and source.Data()) {
 			if (allowStatic and source.IsStatic()) {
+				Destroy();
 				Base::m_isStatic = true;
 				BufferHandle() = source.BufferHandle();
+				m_info.capacity = source.m_info.capacity;
+				m_info.length = source.m_info.length;
 			}
 			else
-				CopyData(source.Data(), source.Capacity(), offset);
+				CopyData(source.Data(), source.Length(), offset);
 		}
 		return *this;
 	}
@@ -563,49 +855,91 @@ public:
 	// ----------------------------------------
 
 	ManagedArray& CopyData(DATA_T const* sourceData, int32_t count, int32_t offset = 0) {
-		if (Resize(count + offset, false))
-			memcpy(Data(offset), sourceData, std::min(m_info.capacity - offset, count) * sizeof(DATA_T));
+		if (Resize(count + offset, offset > 0))
+			std::copy(sourceData, sourceData + count, Data(offset));
 		return *this;
 	}
 
 	// ----------------------------------------
 
 	ManagedArray& Move(ManagedArray& source) {
+		if (source.m_isInlineBuffer)
+			return MoveElements(source);
 		Destroy();
 		memcpy(&m_info, &source.m_info, sizeof(ArrayInfo));
+		m_arena = source.m_arena;
+		m_isArenaBuffer = source.m_isArenaBuffer;
+		m_isRawBuffer = source.m_isRawBuffer;
+		m_alignment = source.m_alignment;
+		m_rawAlignment = source.m_rawAlignment;
+		source.m_isArenaBuffer = false;
+		source.m_isRawBuffer = false;
+		Base::m_isStatic = source.Base::m_isStatic;
 		BufferHandle() = std::move(source.BufferHandle());
 		source.BufferHandle() = nullptr;
 		source.Reset();
 		return *this;
 	}
 
+	// ----------------------------------------
+	// Move that relocates the elements, for sources whose buffer is part of them (inline storage).
+
+	ManagedArray& MoveElements(ManagedArray& source) {
+		Destroy();
+		int32_t length = source.m_info.length;
+		if (Reserve(length) and (m_info.capacity >= length)) {
+			int32_t capacity = m_info.capacity;
+			RelocateElements(Data(), source.Data(), length);
+			source.m_info.length = 0; // nothing left to destroy
+			memcpy(&m_info, &source.m_info, sizeof(ArrayInfo));
+			m_info.capacity = capacity;
+			m_info.length = length;
+		}
+		source.Reset();
+		return *this;
+	}
+
+	// ----------------------------------------
+	// Use capacity elements of raw storage at buffer for arrays that fit into it. The storage must
+	// live as long as the array; the array falls back to it when its buffer is destroyed.
+
+	void SetInlineBuffer(DATA_T* buffer, int32_t capacity) {
+		Destroy();
+		m_inlineBuffer = buffer;
+		m_inlineCapacity = capacity;
+		Reserve(capacity);
+	}
+
 	// ----------------------------------------
 
-	inline DATA_T operator+ (ManagedArray<DATA_T>& source) {
-		ManagedArray<DATA_T> a(*this);
+	inline bool IsInline(void) const {
+		return m_isInlineBuffer;
+	}
+
+	// ----------------------------------------
+
+	inline ManagedArray operator+ (ManagedArray& source) {
+		ManagedArray a(*this);
 		a += source;
 		return a;
 	}
 
 	// ----------------------------------------
 
-	inline DATA_T& operator+= (ManagedArray<DATA_T>& source) {
-		int32_t offset = m_info.capacity;
-		if (BufferHandle())
-			Resize(m_info.capacity + source.m_info.capacity);
-		return CopyData(source, offset);
+	inline ManagedArray& operator+= (ManagedArray& source) {
+		return Append(source, true);
 	}
 
 	// ----------------------------------------
 
 	inline bool operator== (ManagedArray<DATA_T>& other) {
-		return (m_info.capacity == other.m_info.capacity) and not (m_info.capacity and memcmp(Data(), other.Data()));
+		return (m_info.length == other.m_info.length) and ((m_info.length == 0) or ArrayEqual(Data(), other.Data(), m_info.length));
 	}
 
 	// ----------------------------------------
 
 	inline bool operator!= (ManagedArray<DATA_T>& other) {
-		return (m_info.capacity != other.m_info.capacity) or (m_info.capacity and memcmp(Data(), other.Data()));
+		return not (*this == other);
 	}
 
 	// ----------------------------------------
@@ -614,14 +948,14 @@ public:
 
 	// ----------------------------------------
 
-	inline DATA_T* End(void) { return (Data() and m_info.capacity) ? Data() + m_info.capacity - 1 : nullptr; }
+	inline DATA_T* End(void) { return (Data() and m_info.length) ? Data() + m_info.length - 1 : nullptr; }
 
 	// ----------------------------------------
 
 	inline DATA_T* operator++ (void) {
 		if (not Data())
 			return nullptr;
-		if (m_info.pos < m_info.capacity - 1)
+		if (m_info.pos < m_info.length - 1)
 			m_info.pos++;
 		else if (m_info.wrap)
 			m_info.pos = 0;
@@ -638,7 +972,7 @@ public:
 		if (m_info.pos > 0)
 			m_info.pos--;
 		else if (m_info.wrap)
-			m_info.pos = m_info.capacity - 1;
+			m_info.pos = m_info.length - 1;
 		else
 			return nullptr;
 		return Data() + m_info.pos;
@@ -664,7 +998,7 @@ public:
 
 	// ----------------------------------------
 
-	inline void Pos(int32_t pos) { m_info.pos = pos % m_info.capacity; }
+	inline void Pos(int32_t pos) { m_info.pos = m_info.length ? pos % m_info.length : 0; }
 
 	// ----------------------------------------
 
@@ -675,71 +1009,66 @@ public:
 	inline int32_t GetOffset(void) { return m_info.offset; }
 
 	// ----------------------------------------
-#if 0
-	int32_t Read(CFile& cf, int32_t nCount = 0, int32_t nOffset = 0, bool bCompressed = 0) {
-		if (not Data())
-			return -1;
-		if (nOffset >= m_info.capacity)
-			return -1;
-		if (not nCount)
-			nCount = m_info.capacity - nOffset;
-		else if (nCount > m_info.capacity - nOffset)
-			nCount = m_info.capacity - nOffset;
-		return cf.Read(DataPtr() + nOffset, sizeof(DATA_T), nCount, bCompressed);
+	// Write the elements in use to filename as raw data, e.g. to open it as a MappedArray later.
+
+	bool Save(const char* filename) {
+		static_assert(std::is_trivially_copyable_v<DATA_T>, "only arrays of trivially copyable elements can be saved");
+		return MappedFile::Write(filename, Data(), size_t(m_info.length) * sizeof(DATA_T));
 	}
 
 	// ----------------------------------------
 
-	int32_t Write(CFile& cf, int32_t nCount = 0, int32_t nOffset = 0, int32_t bCompressed = 0) {
-		if (not Data())
-			return -1;
-		if (nOffset >= m_info.capacity)
-			return -1;
-		if (not nCount)
-			nCount = m_info.capacity - nOffset;
-		else if (nCount > m_info.capacity - nOffset)
-			nCount = m_info.capacity - nOffset;
-		return cf.Write(DataPtr() + nOffset, sizeof(DATA_T), nCount, bCompressed);
-	}
-#endif
+	inline void SetWrap(bool wrap) { m_info.wrap = wrap; }
 
 	// ----------------------------------------
 
-	inline void SetWrap(bool wrap) { m_info.wrap = wrap; }
+	// parallel: sort large arrays on ThreadPool::Instance() (see ParallelMergeSort)
+	// stable: keep the order of equal elements
+
+	inline void SortAscending(int32_t left = 0, int32_t right = 0, bool parallel = false, bool stable = false) {
+		SortBy(SortLess(), left, right, parallel, stable);
+	}
 
 	// ----------------------------------------
 
-	inline void SortAscending(int32_t left = 0, int32_t right = 0) {
-		if (Data())
-			QuickSort<DATA_T>::SortAscending(Data(), left, (right = 0) ? right : m_info.capacity - 1);
+	inline void SortDescending(int32_t left = 0, int32_t right = 0, bool parallel = false, bool stable = false) {
+		SortBy(SortGreater(), left, right, parallel, stable);
 	}
 
 	// ----------------------------------------
 
-	inline void SortDescending(int32_t left = 0, int32_t right = 0) {
-		if (Data())
-			QuickSort<DATA_T>::SortDescending(Data(), left, (right > 0) ? right : m_info.capacity - 1);
+	inline void SortAscending(QuickSort<DATA_T>::tComparator compare, int32_t left = 0, int32_t right = 0, bool parallel = false, bool stable = false) {
+		SortBy(CompareLess<DATA_T>(compare, 1), left, right, parallel, stable);
 	}
 
 	// ----------------------------------------
 
-	inline void SortAscending(QuickSort<DATA_T>::tComparator compare, int32_t left = 0, int32_t right = 0) {
-		if (Data())
-			QuickSort<DATA_T>::SortAscending(Data(), left, (right > 0) ? right : m_info.capacity - 1, compare);
+	inline void SortDescending(QuickSort<DATA_T>::tComparator compare, int32_t left = 0, int32_t right = 0, bool parallel = false, bool stable = false) {
+		SortBy(CompareLess<DATA_T>(compare, -1), left, right, parallel, stable);
 	}
 
 	// ----------------------------------------
+	// sort by a predicate less(a, b) returning true if a goes before b, e.g. SortGreater or a lambda
 
-	inline void SortDescending(QuickSort<DATA_T>::tComparator compare, int32_t left = 0, int32_t right = 0) {
-		if (Data())
-			QuickSort<DATA_T>::SortDescending(Data(), left, (right > 0) ? right : m_info.capacity - 1, compare);
+	template<typename LESS_T>
+	void SortBy(LESS_T less, int32_t left = 0, int32_t right = 0, bool parallel = false, bool stable = false) {
+		if (not Data())
+			return;
+		if (right <= 0)
+			right = m_info.length - 1;
+		if (parallel)
+			ParallelMergeSort<DATA_T, LESS_T>::Sort(Data() + left, right - left + 1, less, stable);
+		else if (stable)
+			std::stable_sort(Data() + left, Data() + right + 1, less);
+		else
+			QuickSort<DATA_T>::Sort(Data(), left, right, less);
 	}
 
 	// ----------------------------------------
 
 	template<typename KEY_T>
 	inline int32_t Find(KEY_T const& key, int(__cdecl* compare) (DATA_T const&, KEY_T const&), int32_t left = 0, int32_t right = 0) {
-		return Data() ? this->BinSearch(Data(), key, compare, left, (right > 0) ? right : m_info.capacity - 1) : -1;
+		return Data() ? this->BinSearch(Data(), key, compare, left, (right > 0) ? right : m_info.length - 1) : -1;
 	}
 };
 
@@ -758,13 +1087,101 @@ class CharArray : public ManagedArray<char> {
 public:
 	inline char* operator= (const char* source) {
 		int32_t l = int32_t(strlen(source) + 1);
-		if ((l > this->m_info.capacity) and not this->Resize(this->m_info.capacity + l))
+		if (not this->Resize(l))
 			return nullptr;
 		memcpy(this->Data(), source, l);
 		return this->Data();
 	}
 };
 
+// =================================================================================================
+// An array whose elements are a file mapped into memory (see MappedFile), e.g. a large table saved
+// with ManagedArray::Save. Opening it takes about as long as opening the file; the elements are read
+// in as they are accessed. The file size must be a multiple of the element size.
+// The mapping is a static buffer of the array: everything that reads elements works on the mapping
+// directly. Writing to a read-only mapping crashes; use CopyOnWrite to change elements in memory.
+// Growing the array beyond the file size moves the elements to the heap, like with any other static
+// buffer. Arrays copied from a MappedArray share the mapping and must not outlive it.
+
+template<typename DATA_T>
+class MappedArray : public ManagedArray<DATA_T> {
+	static_assert(std::is_trivially_copyable_v<DATA_T>, "only arrays of trivially copyable elements can be mapped");
+
+public:
+	using Mode = MappedFile::Mode;
+	using Access = MappedFile::Access;
+
+private:
+	MappedFile	m_file;
+
+public:
+	MappedArray() = default;
+
+	explicit MappedArray(const char* filename, Mode mode = Mode::ReadOnly, Access access = Access::Normal) {
+		Open(filename, mode, access);
+	}
+
+	~MappedArray() {
+		Close();
+	}
+
+	MappedArray(const MappedArray&) = delete;
+	MappedArray& operator=(const MappedArray&) = delete;
+
+	// ----------------------------------------
+
+	bool Open(const char* filename, Mode mode = Mode::ReadOnly, Access access = Access::Normal) {
+		Close();
+		if (not m_file.Open(filename, mode))
+			return false;
+		size_t length = m_file.Size() / sizeof(DATA_T);
+		DATA_T* data = reinterpret_cast<DATA_T*>(m_file.GetAddress());
+		if ((m_file.Size() % sizeof(DATA_T)) or (length > size_t(INT32_MAX)) or (uintptr_t(data) % alignof(DATA_T))) {
+			m_file.Close();
+			return false;
+		}
+		if (length) {
+			this->SetBuffer(data, int32_t(length));
+			if (access != Access::Normal)
+				m_file.Advise(access);
+		}
+		return true;
+	}
+
+	// ----------------------------------------
+
+	void Close(void) {
+		this->Reset();
+		m_file.Close();
+	}
+
+	// ----------------------------------------
+	// hint how elements [first, first + count) will be accessed; count 0 means up to the end
+
+	inline bool Advise(Access access, int32_t first = 0, int32_t count = 0) {
+		return IsMapped() and m_file.Advise(access, size_t(first) * sizeof(DATA_T), size_t(count) * sizeof(DATA_T));
+	}
+
+	// ----------------------------------------
+	// the elements still are the mapping, i.e. the array has not been moved to the heap
+
+	inline bool IsMapped(void) const {
+		return this->Data() and (this->Data() == m_file.GetAddress());
+	}
+
+	// ----------------------------------------
+
+	inline bool IsOpen(void) const {
+		return m_file.IsOpen();
+	}
+
+	// ----------------------------------------
+
+	inline Mode GetMode(void) const {
+		return m_file.GetMode();
+	}
+};
+
 // =================================================================================================
 
 template<typename DATA_T>
@@ -773,7 +1190,7 @@ using SharedArray = ManagedArray<DATA_T, SharedPointer<DATA_T>>;
 class ByteArray : public ManagedArray<uint8_t> {
 public:
 	ByteArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -781,7 +1198,7 @@ public:
 class ShortArray : public ManagedArray<int16_t> {
 public:
 	ShortArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -789,7 +1206,7 @@ public:
 class UShortArray : public ManagedArray<uint16_t> {
 public:
 	UShortArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -797,7 +1214,7 @@ public:
 class IntArray : public ManagedArray<int32_t> {
 public:
 	IntArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -805,7 +1222,7 @@ public:
 class UIntArray : public ManagedArray<int32_t> {
 public:
 	UIntArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -813,7 +1230,7 @@ public:
 class SizeArray : public ManagedArray<size_t> {
 public:
 	SizeArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -821,7 +1238,7 @@ public:
 class FloatArray : public ManagedArray<float> {
 public:
 	FloatArray(const int32_t nLength) {
-		Reserve(nLength);
+		Resize(nLength);
 		Init();
 	}
 };
@@ -845,23 +1262,260 @@ public:
 };
 
 // =================================================================================================
+// Array keeping up to capacity elements inside the array object, spilling them to the heap only
+// when it grows beyond that, and returning to the inline storage when its buffer is destroyed or
+// shrunk to fit into it. Unlike StaticArray it is not limited to capacity elements, and only the
+// elements in use are constructed. Moving an array whose elements are inline relocates them.
+
+template < class DATA_T, int32_t capacity >
+class SmallArray : public ManagedArray < DATA_T > {
+	static_assert(capacity > 0, "SmallArray needs inline storage");
+
+protected:
+	alignas(DATA_T) unsigned char	m_storage[capacity * sizeof(DATA_T)];
+
+public:
+	using ManagedArray<DATA_T>::operator=;
+
+	SmallArray() {
+		this->SetInlineBuffer(reinterpret_cast<DATA_T*>(m_storage), capacity);
+	}
+
+	explicit SmallArray(const int32_t length) : SmallArray() {
+		this->Resize(length);
+	}
+
+	SmallArray(std::initializer_list<DATA_T> data) : SmallArray() {
+		ManagedArray<DATA_T>::operator=(data);
+	}
+
+	SmallArray(const SmallArray& other) : SmallArray() {
+		this->CopyData(other);
+	}
+
+	SmallArray(SmallArray&& other) : SmallArray() {
+		this->Move(other);
+	}
+
+	~SmallArray() {
+		this->Destroy(); // before the inline storage goes away
+	}
+
+	SmallArray& operator= (const SmallArray& other) {
+		this->CopyData(other);
+		return *this;
+	}
+
+	SmallArray& operator= (SmallArray&& other) {
+		if (this != &other)
+			this->Move(other);
+		return *this;
+	}
+
+	static constexpr int32_t InlineCapacity(void) {
+		return capacity;
+	}
+};
+
+// =================================================================================================
+
+// A grid of cols x rows elements, addressed as (x, y) with 0 <= x < cols and 0 <= y < rows, in
+// one of these layouts:
+// - RowMajor: rows one after the other, each starting on a cache line, so that walking a column
+//   touches one cache line per row and rows can be processed by different threads without sharing
+//   cache lines.
+// - Tiled: the grid is cut into tiles of TILE_SIZE x TILE_SIZE elements, which are stored one after
+//   the other, row by row; a tile is one contiguous block, so walking a column touches a new cache
+//   line only every TILE_SIZE rows, and a tile's neighbours in both directions are close in memory.
+// - Morton: tiled, with the elements of each tile in Z-order (Morton order), so that small square
+//   neighbourhoods (e.g. of filter kernels) lie in as few cache lines as possible.
+// Rows and tiles are padded to whole cache lines and tiles; the padding holds default elements.
+// GetRow only works for RowMajor grids, whose rows are contiguous.
+// ForEach, ForEachRow, ForEachTile and Transform walk the grid in storage order and run on
+// ThreadPool::Instance() if parallel is set, each thread processing whole bands of TILE_SIZE rows.
 
 template < typename DATA_T >
 class Array2D : public ManagedArray < DATA_T > {
 public:
-	int32_t	m_rows;
-	int32_t	m_cols;
+	enum class Layout : uint8_t {
+		RowMajor,
+		Tiled,
+		Morton
+	};
+
+	static constexpr int32_t TILE_SHIFT = 4;
+	static constexpr int32_t TILE_SIZE = 1 << TILE_SHIFT;
+	static constexpr int32_t TILE_MASK = TILE_SIZE - 1;
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+
+	using ManagedArray<DATA_T>::Index;
+	using ManagedArray<DATA_T>::IsValidIndex;
+
+	int32_t	m_rows = 0;
+	int32_t	m_cols = 0;
+
+protected:
+	int32_t	m_pitch = 0;		// elements from one row to the next (RowMajor)
+	int32_t	m_tileCols = 0;		// tiles per row of tiles (Tiled, Morton)
+	Layout	m_layout = Layout::RowMajor;
+
+public:
+	Array2D() = default;
 
-	DATA_T& operator()(int32_t x, int32_t y) {
-		return this->Data(x * m_cols + y);
+	Array2D(int32_t cols, int32_t rows, Layout layout = Layout::RowMajor) {
+		Create(cols, rows, layout);
 	}
 
-	const DATA_T& operator()(int32_t x, int32_t y) const {
-		return this->Data(x * m_cols + y);
+	// ----------------------------------------
+	// Set up an empty grid; returns false if it could not be allocated.
+
+	bool Create(int32_t cols, int32_t rows, Layout layout = Layout::RowMajor) {
+		this->Destroy();
+		m_cols = std::max(cols, 0);
+		m_rows = std::max(rows, 0);
+		m_layout = layout;
+		int64_t size;
+		if (layout == Layout::RowMajor) {
+			// smallest element count whose size is a multiple of the cache line: lcm(line, element) / element
+			int32_t lineElements = int32_t(CACHE_LINE_SIZE / std::gcd(CACHE_LINE_SIZE, sizeof(DATA_T)));
+			m_pitch = (m_cols + lineElements - 1) / lineElements * lineElements;
+			m_tileCols = 0;
+			size = int64_t(m_pitch) * m_rows;
+		}
+		else {
+			m_pitch = 0;
+			m_tileCols = (m_cols + TILE_MASK) >> TILE_SHIFT;
+			size = int64_t(m_tileCols) * ((m_rows + TILE_MASK) >> TILE_SHIFT) << (2 * TILE_SHIFT);
+		}
+		this->Init(m_cols, m_rows);
+		if (size > INT32_MAX)
+			return false;
+		this->SetAlignment(CACHE_LINE_SIZE);
+		return (size == 0) or this->Resize(int32_t(size), false);
+	}
+
+	// ----------------------------------------
+
+	inline int32_t Index(int32_t x, int32_t y) const {
+		if (m_layout == Layout::RowMajor)
+			return y * m_pitch + x;
+		int32_t tile = ((y >> TILE_SHIFT) * m_tileCols + (x >> TILE_SHIFT)) << (2 * TILE_SHIFT);
+		if (m_layout == Layout::Tiled)
+			return tile + ((y & TILE_MASK) << TILE_SHIFT) + (x & TILE_MASK);
+		return tile + MortonCode(x & TILE_MASK, y & TILE_MASK);
+	}
+
+	// ----------------------------------------
+
+	inline DATA_T& operator()(int32_t x, int32_t y) {
+		return this->Data()[Index(x, y)];
+	}
+
+	inline const DATA_T& operator()(int32_t x, int32_t y) const {
+		return this->Data()[Index(x, y)];
 	}
 
-	DATA_T* GetRow(int32_t y) {
-		return this->Data(y * m_cols);
+	// ----------------------------------------
+
+	inline bool IsValidIndex(int32_t x, int32_t y) const {
+		return (x >= 0) and (x < m_cols) and (y >= 0) and (y < m_rows);
+	}
+
+	// ----------------------------------------
+
+	inline DATA_T* GetRow(int32_t y) {
+		return (m_layout == Layout::RowMajor) ? this->Data() + y * m_pitch : nullptr;
+	}
+
+	inline DATA_T* DataRow(int32_t y) {
+		return GetRow(y);
+	}
+
+	// ----------------------------------------
+
+	inline Layout GetLayout(void) const {
+		return m_layout;
+	}
+
+	inline int32_t Cols(void) const {
+		return m_cols;
+	}
+
+	inline int32_t Rows(void) const {
+		return m_rows;
+	}
+
+	// ----------------------------------------
+	// process(y) for every row
+
+	template <typename PROCESS_T>
+	void ForEachRow(PROCESS_T&& process, bool parallel = false) {
+		ForEachBand([&](int32_t y0, int32_t y1) {
+			for (int32_t y = y0; y < y1; y++)
+				process(y);
+			}, parallel);
+	}
+
+	// ----------------------------------------
+	// process(x0, y0, x1, y1) for every tile [x0, x1) x [y0, y1), clipped to the grid
+
+	template <typename PROCESS_T>
+	void ForEachTile(PROCESS_T&& process, bool parallel = false) {
+		ForEachBand([&](int32_t y0, int32_t y1) {
+			for (int32_t x0 = 0; x0 < m_cols; x0 += TILE_SIZE)
+				process(x0, y0, std::min(x0 + TILE_SIZE, m_cols), y1);
+			}, parallel);
+	}
+
+	// ----------------------------------------
+	// process(x, y, element) for every element; row by row for RowMajor grids, tile by tile otherwise
+
+	template <typename PROCESS_T>
+	void ForEach(PROCESS_T&& process, bool parallel = false) {
+		if (m_layout == Layout::RowMajor)
+			ForEachRow([&](int32_t y) {
+				DATA_T* row = GetRow(y);
+				for (int32_t x = 0; x < m_cols; x++)
+					process(x, y, row[x]);
+				}, parallel);
+		else
+			ForEachTile([&](int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+				for (int32_t y = y0; y < y1; y++)
+					for (int32_t x = x0; x < x1; x++)
+						process(x, y, (*this)(x, y));
+				}, parallel);
+	}
+
+	// ----------------------------------------
+	// element = transform(element) for every element
+
+	template <typename TRANSFORM_T>
+	void Transform(TRANSFORM_T&& transform, bool parallel = false) {
+		ForEach([&](int32_t, int32_t, DATA_T& element) { element = transform(std::as_const(element)); }, parallel);
+	}
+
+private:
+	// interleave the bits of x and y (both less than TILE_SIZE)
+	static inline int32_t MortonCode(int32_t x, int32_t y) {
+		static constexpr uint8_t spread[16] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15, 0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55 };
+		static_assert(TILE_SIZE <= 16, "MortonCode needs a wider spread table for larger tiles");
+		return int32_t(spread[x]) | (int32_t(spread[y]) << 1);
+	}
+
+	// process(y0, y1) for all bands [y0, y1) of TILE_SIZE rows
+	template <typename PROCESS_T>
+	void ForEachBand(PROCESS_T&& process, bool parallel) {
+		int32_t bands = (m_rows + TILE_MASK) >> TILE_SHIFT;
+		auto processBand = [&](int32_t band) {
+			int32_t y0 = band << TILE_SHIFT;
+			process(y0, std::min(y0 + TILE_SIZE, m_rows));
+		};
+		if (parallel)
+			ThreadPool::Instance().ParallelFor(bands, processBand);
+		else {
+			for (int32_t band = 0; band < bands; band++)
+				processBand(band);
+		}
 	}
 };
 
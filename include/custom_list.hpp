@@ -16,9 +16,14 @@
 #include <cstddef>
 #include <utility>
 #include <iostream>
+#include <iterator>
+#include <cassert>
 
 #include "type_helper.hpp"
 #include "array.hpp"
+#include "monotonicarena.hpp"
+#include "nodepool.hpp"
+#include "quicksort.hpp"
 
 //-----------------------------------------------------------------------------
 
@@ -200,7 +205,7 @@ public:
 }
 
 			ListNode(ItemType&& dataValue, bool manageData = false)
-				: m_pred(nullptr), m_succ(nullptr), m_dataItem(dataValue), m_manageData(manageData)
+				: m_pred(nullptr), m_succ(nullptr), m_dataItem(std::move(dataValue)), m_manageData(manageData)
 			{
 			}
 
@@ -291,173 +296,142 @@ public:
 
 	//----------------------------------------
 
+	// Bidirectional iterator holding nothing but the current node, so it costs no more than a raw
+	// pointer. end() is the tail sentinel; iterators stay valid until their node is removed.
 	class Iterator {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = ItemType;
+		using difference_type = std::ptrdiff_t;
+		using pointer = ItemType*;
+		using reference = ItemType&;
 
 	private:
-		ListNodePtr 	m_first;
-		ListNodePtr 	m_last;
-		ListNodePtr 	m_current;
-		int32_t			m_index;
-		int32_t			m_length;
+		ListNode*	m_node;
 
 	public:
-		explicit Iterator() {}
-
-		Iterator(List<ItemType>& l)
-			: m_first(l.First()), m_last(l.Last()), m_index(0), m_length(l.Length())
-		{
-			m_current = m_first;
-		}
-
-		Iterator(const List<ItemType>& l)
-			: m_first(l.First()), m_last(l.Last()), m_index(0), m_length(0)
-		{
-			m_current = m_first;
-		}
+		explicit Iterator(ListNode* node = nullptr)
+			: m_node(node)
+		{ }
 
-		operator bool() const { return m_current != nullptr; }
-#if 0
-		ItemType* operator*() {
-			return m_current.DataPointer();
+		explicit operator bool() const {
+			return m_node != nullptr;
 		}
 
-		const ItemType* operator*() const {
-			return m_current;
-		}
-#endif
-		//ItemType* operator*() const { return &m_current->m_dataItem; }
-		// return the current value and the index of the value in the list
-		ItemType& operator*() {
-			return m_current.DataValue();
+		inline ItemType& operator*() const {
+			return m_node->m_dataItem;
 		}
 
-		ItemType* operator->() {
-			return m_current.DataPointer();
+		inline DataType* operator->() const {
+			return m_node->DataPointer();
 		}
 
 		inline Iterator& operator++() {
-			++m_current;
-			++m_index;
+			m_node = m_node->m_succ.m_nodePtr;
 			return *this;
 		}
 
 		inline Iterator& operator--() {
-			--m_current;
-			--m_index;
+			m_node = m_node->m_pred.m_nodePtr;
 			return *this;
 		}
 
-		inline Iterator& operator++(int) {
-			m_current++;
-			m_index++;
-			return *this;
-		}
-
-		inline Iterator& operator--(int) {
-			m_current--;
-			m_index--;
-			return *this;
-		}
-
-		bool operator==(const Iterator& other) const {
-			return m_current == other.m_current;
+		inline Iterator operator++(int) {
+			Iterator it = *this;
+			m_node = m_node->m_succ.m_nodePtr;
+			return it;
 		}
 
-		bool operator!=(const Iterator& other) const {
-			return m_current != other.m_current;
+		inline Iterator operator--(int) {
+			Iterator it = *this;
+			m_node = m_node->m_pred.m_nodePtr;
+			return it;
 		}
 
-		bool operator==(const ListNodePtr& other) const {
-			return m_current == other;
+		inline bool operator==(const Iterator& other) const {
+			return m_node == other.m_node;
 		}
 
-		bool operator!=(const ListNodePtr& other) const {
-			return m_current != other;
+		inline bool operator!=(const Iterator& other) const {
+			return m_node != other.m_node;
 		}
 
+		// advance n nodes, stopping at the tail
 		Iterator operator+(int n) const {
 			Iterator it = *this;
-			while ((n-- > 0) and (it != m_last)) {
+			while ((n-- > 0) and it.m_node->m_succ.m_nodePtr)
 				++it;
-			}
 			return it;
 		}
 
+		// step back n nodes, stopping at the first item
 		Iterator operator-(int n) const {
 			Iterator it = *this;
-			while ((n-- > 0) and (it != m_first)) {
+			while ((n-- > 0) and it.m_node->m_pred.m_nodePtr and it.m_node->m_pred->m_pred.m_nodePtr)
 				--it;
-			}
 			return it;
 		}
 
-		//Iterator& Start(void) {
-		constexpr Iterator& First(void) {
-			m_index = 0;
-			m_current = m_first;
-			return *this;
+		inline ListNode* Node(void) const {
+			return m_node;
 		}
+	};
 
-		Iterator& Last(void) {
-			m_current = m_last;
-			return *this;
-		}
+	using ReverseIterator = std::reverse_iterator<Iterator>;
 
-		inline int32_t Index(void) {
-			return m_index;
-		}
-	};
+	using NodePoolType = NodePool<ListNode>;
 
 	// ----------------------------------------
 	// This list implementation uses two dummy entries as head and tail elements,
 	// as this makes many operations on the list much easier.
-	// Since the list can always store a ItemType*, head and tail will be initialized 
-	// with a ItemType*, which is quite memory efficient.
+	// Head and tail are embedded in the list object; item nodes come from a node pool,
+	// so appending and extracting items does not touch the heap once the pool has grown.
 
 protected:
 	const char* m_name;
+	ListNode	m_headNode;
+	ListNode	m_tailNode;
 	ListNode*	m_head;
 	ListNode*	m_tail;
 	ListNodePtr	m_headPtr;
 	ListNodePtr	m_tailPtr;
 	ItemType*	m_none;
 
-	// holds a copy of the median data for sorting; one global variable should work 
-	// as it is only used during the sorting part and not during the recursive descent
-	ItemType	m_median;
-	tComparator	m_compare;
-
 	int32_t		m_length;
 	bool		m_result;
 	bool		m_isValid;
+	MonotonicArena*	m_arena = nullptr;	// allocate item nodes from this arena instead of the node pool
+	NodePoolType	m_nodePool;
+	NodePoolType*	m_sharedPool = nullptr;	// allocate item nodes from this pool instead of m_nodePool
+	// finger: the node last accessed by index, so that sequential and nearby indexed accesses
+	// only walk a few nodes. Insertions and removals keep it up to date.
+	ListNode*		m_finger = nullptr;
+	int32_t			m_fingerIndex = 0;
 
 public:
+	// forget all item nodes without releasing them
 	inline void Reset(void) {
-		m_head = nullptr;
-		m_tail = nullptr;
-		m_headPtr = nullptr;
-		m_tailPtr = nullptr;
+		m_head = &m_headNode;
+		m_tail = &m_tailNode;
+		m_headPtr = m_head;
+		m_tailPtr = m_tail;
+		m_headPtr.Pred() =
+		m_tailPtr.Succ() = nullptr;
+		m_headPtr.Succ() = m_tail;
+		m_tailPtr.Pred() = m_head;
 		m_length = 0;
-		m_isValid = false;
+		m_finger = nullptr;
 	}
 
 
 	inline void Init(void) {
 		if (not m_isValid) {
 			m_isValid = true;
-			m_head = new ListNode();
-			m_tail = new ListNode();
 			if constexpr (std::is_pointer_v<ItemType>)
 				m_none = nullptr;
 			else
 				m_none = new ItemType();
-			m_headPtr = m_head;
-			m_tailPtr = m_tail;
-			m_headPtr.Pred() =
-			m_tailPtr.Succ() = nullptr;
-			m_headPtr.Succ() = m_tail;
-			m_tailPtr.Pred() = m_head;
-			m_length = 0;
+			Reset();
 		}
 	}
 
@@ -467,22 +441,83 @@ public:
 				ListNodePtr p = n;
 				++n;
 				if (p.m_nodePtr) {
-					delete p.m_nodePtr;
+					FreeNode(p.m_nodePtr);
 					p.m_nodePtr = nullptr;
 				}
 			}
+			m_length = 0;
+			m_finger = nullptr;
 		}
 	}
 
+	// Allocate item nodes from arena. Only possible while the list is empty; the list must not
+	// outlive the arena scope its nodes were allocated in.
+	bool SetArena(MonotonicArena* arena) {
+		if (m_length)
+			return false;
+		m_arena = arena;
+		return true;
+	}
+
+	inline MonotonicArena* GetArena(void) const {
+		return m_arena;
+	}
+
+	// Allocate item nodes from a pool shared with other lists, or from the list's own pool if pool
+	// is nullptr. Only possible while the list is empty. The pool of another list is destroyed
+	// with that list, so all lists sharing it must be destroyed (or given another pool) first.
+	bool SetNodePool(NodePoolType* pool) {
+		if (m_length)
+			return false;
+		ShareNodePool((pool == &m_nodePool) ? nullptr : pool);
+		return true;
+	}
+
+private:
+	inline void ShareNodePool(NodePoolType* pool) {
+		if (m_sharedPool)
+			m_sharedPool->RemoveUser();
+		m_sharedPool = pool;
+		if (m_sharedPool)
+			m_sharedPool->AddUser();
+	}
+
+public:
+	inline NodePoolType& GetNodePool(void) {
+		return m_sharedPool ? *m_sharedPool : m_nodePool;
+	}
+
+	template <typename... ARGS>
+	inline ListNode* AllocNode(ARGS&&... args) {
+		return m_arena ? m_arena->New<ListNode>(std::forward<ARGS>(args)...) : GetNodePool().New(std::forward<ARGS>(args)...);
+	}
+
+	inline void FreeNode(ListNode* node) {
+		if (m_arena)
+			node->~ListNode();
+		else
+			GetNodePool().Delete(node);
+	}
+
+	// nodes of lists sharing an allocator can be relinked from one list to the other
+	inline bool SharesNodes(const List<ItemType>& other) const {
+		return (m_arena == other.m_arena) and (m_sharedPool == other.m_sharedPool);
+	}
+
 	void Destroy(void) {
 		if (m_isValid) {
 			m_isValid = false;
 			Clear();
-			delete m_head;
-			delete m_tail;
+			ShareNodePool(nullptr);
+			assert((m_nodePool.UserCount() == 0) and "lists sharing this list's node pool must be destroyed first");
+			m_nodePool.Destroy();
 			delete m_none;
+			m_headNode.m_succ = nullptr; // keeps the sentinels' destructors from unlinking them
+			m_tailNode.m_pred = nullptr;
 			m_head = 
 			m_tail = nullptr;
+			m_headPtr =
+			m_tailPtr = nullptr;
 			m_none = nullptr;
 		}
 	}
@@ -490,25 +525,25 @@ public:
 	List<ItemType>& Copy(const List<ItemType>& other) {
 		if (other.Length()) {
 			for (ListNode* pn = other.First(); pn != other.GetTail(); pn = pn->Succ())
-				AddNode(-1, new ListNode(*pn));
+				AddNode(-1, AllocNode(*pn));
 		}
 		return *this;
 	}
 
-	Iterator begin() const {
-		return Iterator(*this).First();
+	inline Iterator begin() const {
+		return Iterator(m_head->m_succ.m_nodePtr);
 	}
 
-	Iterator end() const {
-		return Iterator(*this).Last();
+	inline Iterator end() const {
+		return Iterator(m_tail);
 	}
 
-	Iterator rbegin() const {
-		return Iterator(*this).ReverseFirst();
+	inline ReverseIterator rbegin() const {
+		return ReverseIterator(end());
 	}
 
-	Iterator rend() const {
-		return Iterator(*this).ReverseLast();
+	inline ReverseIterator rend() const {
+		return ReverseIterator(begin());
 	}
 
 	inline ListNode* GetHead(void) const {
@@ -570,7 +605,10 @@ public:
 	}
 #endif
 	inline List<ItemType>& operator= (List<ItemType> const& other) {
-		Copy(other);
+		if (&other != this) {
+			Clear();
+			Copy(other);
+		}
 		return *this;
 	}
 
@@ -636,35 +674,52 @@ public:
 	//-----------------------------------------------------------------------------
 
 public:
-	inline ListNode* NodePtrAt(int i) {
-		return NodePtrAt(i, m_headPtr + 1, m_tailPtr - 1);
-	}
-
-
-	ListNode* NodePtrAt(int i, ListNode* first, ListNode* last) {
-		if (i == 0)
-			return first;
-		if (i == -1)
-			return last;
-
-		if (not IsAvailable() or (abs(i) > m_length - 1)) {
+	// node of the i-th item; negative indices count from the end of the list (-1 is the last item).
+	// The walk starts at whichever of head, tail and finger is closest to the item.
+	ListNode* NodePtrAt(int i) {
+		if (i < 0)
+			i += m_length;
+		if (not IsAvailable() or (i < 0) or (i >= m_length)) {
 			m_result = false;
 			return static_cast<ListNode*>(nullptr);
 		}
-
-		if (i > m_length / 2)
-			i = -(int(m_length) - i);
-		ListNodePtr p;
-		if (i > 0) {
-			for (p = first; (i > 0) and (p != m_tailPtr); i--)
-				++p;
+		ListNode* p = m_head;
+		int32_t pos = -1;
+		if (m_length - i < i + 1) {
+			p = m_tail;
+			pos = m_length;
+		}
+		if (m_finger and (abs(i - m_fingerIndex) < abs(i - pos))) {
+			p = m_finger;
+			pos = m_fingerIndex;
 		}
+		for (; pos < i; pos++)
+			p = p->m_succ;
+		for (; pos > i; pos--)
+			p = p->m_pred;
+		m_finger = p;
+		m_fingerIndex = i;
+		m_result = true;
+		return p;
+	}
+
+	// node to insert the i-th item in front of; -1 (or the list length) yields the tail
+	inline ListNode* InsertionPoint(int i) {
+		if (i < 0)
+			i += m_length + 1;
+		return (i == m_length) ? m_tail : NodePtrAt(i);
+	}
+
+	// unlink and release node; the finger survives if it is the node (as after NodePtrAt)
+	inline void ReleaseNode(ListNode* node) {
+		if (m_finger != node)
+			m_finger = nullptr;
 		else {
-			for (p = last; (++i < 0) and (p != m_headPtr); )
-				--p;
+			m_finger = (node->m_pred.m_nodePtr == m_head) ? nullptr : node->m_pred.m_nodePtr;
+			--m_fingerIndex;
 		}
-		m_result = i == 0;
-		return m_result ? p.m_nodePtr : static_cast<ListNode*>(nullptr);
+		FreeNode(node);
+		m_length--;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -673,16 +728,21 @@ public:
 	ListNode* AddNode(int i, ListNode* newNode = nullptr, bool manageData = false) {
 		if (not IsAvailable())
 			return nullptr;
-		ListNode* insertBefore = NodePtrAt(i, m_headPtr + 1, m_tailPtr);
+		ListNode* insertBefore = InsertionPoint(i);
 		if (not insertBefore)
 			return nullptr;
-		if (not newNode and (not (newNode = new ListNode())))
+		if (not newNode and (not (newNode = AllocNode())))
 			return nullptr;
 		newNode->m_pred = insertBefore->m_pred;
 		insertBefore->m_pred->m_succ = newNode;
 		newNode->m_succ = insertBefore;
 		newNode->m_manageData = manageData;
 		insertBefore->m_pred = newNode;
+		// the new node becomes the finger; otherwise it takes over the index of insertBefore,
+		// which NodePtrAt made the finger
+		if (insertBefore == m_tail)
+			m_fingerIndex = m_length;
+		m_finger = newNode;
 		m_length++;
 		return newNode;
 	}
@@ -712,12 +772,11 @@ public:
 		if (not m_length)
 			return *m_none;
 
-		ListNode* node = NodePtrAt(i, m_headPtr + 1, m_tailPtr - 1);
+		ListNode* node = NodePtrAt(i);
 		if (not node)
 			return *m_none;
 		ItemType data = node->DataValue();
-		delete node;
-		m_length--;
+		ReleaseNode(node);
 		m_result = true;
 		return data;
 	}
@@ -729,12 +788,11 @@ public:
 		if (not m_length)
 			return false;
 
-		ListNode* node = NodePtrAt(i, m_headPtr + 1, m_tailPtr - 1);
+		ListNode* node = NodePtrAt(i);
 		if (not node)
 			return false;
 		data = node->DataValue();
-		delete node;
-		m_length--;
+		ReleaseNode(node);
 		return true;
 	}
 
@@ -744,11 +802,10 @@ public:
 	bool Discard(int i) {
 		if (not m_length)
 			return false;
-		ListNode* node = NodePtrAt(i, m_headPtr + 1, m_tailPtr - 1);
+		ListNode* node = NodePtrAt(i);
 		if (not node)
-			return *m_none;
-		delete node;
-		m_length--;
+			return false;
+		ReleaseNode(node);
 		return m_result = true;
 	}
 
@@ -766,22 +823,96 @@ public:
 	}
 
 
-	List<ItemType>& operator+= (List<ItemType>&& other) { // move other to end of *this
-		if (other.IsEmpty())
+	inline List<ItemType>& operator+= (List<ItemType>&& other) { // move other to end of *this
+		return Concatenate(std::move(other));
+	}
+
+	//-----------------------------------------------------------------------------
+	// Node relinking. Nodes can only be moved to a list that allocates them the same way: lists
+	// sharing a node pool (SetNodePool) or an arena exchange any node range in O(1). A list using
+	// its own node pool can only hand over all of its nodes at once (it merges its pool into the
+	// receiving list's pool); for partial ranges, the items are moved into new nodes instead.
+
+	// move all nodes of other to the end of this list; O(1) when the lists share their nodes
+	List<ItemType>& Concatenate(List<ItemType>&& other) {
+		if (other.IsEmpty() or (&other == this))
 			return *this;
 		if (IsEmpty())
 			return Move(other);
-		ListNodePtr thisLast = ListNodePtr(Last());
-		ListNodePtr otherFirst = ListNodePtr(other.First());
-		thisLast.Succ() = otherFirst;
-		otherFirst.Pred() = thisLast;
-		std::swap(m_tail, other.m_tail);
-		std::swap(m_tailPtr, other.m_tailPtr);
-		other.m_headPtr.Succ() = other.m_tail;
-		other.m_tailPtr.Pred() = other.m_head;
+		SpliceRange(m_tail, other, other.m_head->m_succ, other.m_tail->m_pred, other.m_length);
 		return *this;
 	}
 
+
+	// Move the nodes first .. last (inclusive) of src in front of dstPos, which may be GetTail()
+	// to append them; src may be this list if dstPos does not lie in the range. count is the
+	// number of nodes in the range; if it is not given, the range is counted.
+	bool SpliceRange(ListNode* dstPos, List<ItemType>& src, ListNode* first, ListNode* last, int32_t count = -1) {
+		if (not (dstPos and first and last) or (first == src.m_head) or (last == src.m_tail) or (dstPos == m_head))
+			return false;
+		if ((dstPos == first) or (dstPos == last->m_succ.m_nodePtr))
+			return true;
+		bool isWholeList = (first == src.m_head->m_succ.m_nodePtr) and (last == src.m_tail->m_pred.m_nodePtr);
+		// a whole list's nodes are relinked by taking over its pool, unless other lists share that pool
+		bool canRelink = SharesNodes(src) and (m_arena or m_sharedPool or (isWholeList and not src.m_nodePool.UserCount()));
+		if ((&src != this) and not canRelink) {
+			for (ListNode* node = first; ; ) { // nodes cannot change their allocator
+				ListNode* succ = node->m_succ;
+				bool isLast = (node == last);
+				ListNode* newNode = AllocNode(std::move(node->m_dataItem), node->m_manageData);
+				if (not newNode)
+					return false;
+				LinkBefore(dstPos, newNode);
+				node->m_manageData = false; // ownership of the item went to newNode
+				src.FreeNode(node);
+				src.m_length--;
+				m_length++;
+				if (isLast)
+					break;
+				node = succ;
+			}
+			m_finger = nullptr;
+			src.m_finger = nullptr;
+			return true;
+		}
+		if (&src != this) {
+			if (count < 0) {
+				count = 1;
+				for (ListNode* node = first; node != last; node = node->m_succ)
+					count++;
+			}
+			if (isWholeList and not (m_arena or m_sharedPool))
+				m_nodePool.Merge(src.m_nodePool);
+		}
+		first->m_pred->m_succ = last->m_succ;
+		last->m_succ->m_pred = first->m_pred;
+		first->m_pred = dstPos->m_pred;
+		dstPos->m_pred->m_succ = first;
+		last->m_succ = dstPos;
+		dstPos->m_pred = last;
+		if (&src != this) {
+			src.m_length -= count;
+			m_length += count;
+		}
+		m_finger = nullptr;
+		src.m_finger = nullptr;
+		return true;
+	}
+
+
+	// move node from src in front of dstPos
+	inline bool SpliceNode(ListNode* dstPos, List<ItemType>& src, ListNode* node) {
+		return SpliceRange(dstPos, src, node, node, 1);
+	}
+
+private:
+	inline void LinkBefore(ListNode* dstPos, ListNode* node) {
+		node->m_pred = dstPos->m_pred;
+		node->m_succ = dstPos;
+		dstPos->m_pred->m_succ = node;
+		dstPos->m_pred = node;
+	}
+
 	//-----------------------------------------------------------------------------
 	// move the other list to this list. current list content will be removed first.
 	// will leave other list empty
@@ -789,13 +920,21 @@ public:
 public:
 	List<ItemType>& Move(List<ItemType>& other) {
 		Destroy();
-		if (not other.IsAvailable())
-			Init();
-		else {
-			m_head = other.m_head;
-			m_tail = other.m_tail;
-			m_headPtr = other.m_head;
-			m_tailPtr = other.m_tail;
+		Init();
+		m_arena = other.m_arena;
+		ShareNodePool(other.m_sharedPool);
+		if (other.IsAvailable() and other.m_length) {
+			if (not (m_arena or m_sharedPool) and not m_nodePool.Merge(other.m_nodePool)) {
+				// lists sharing other's pool keep it alive, so the items move to nodes of this list's pool
+				SpliceRange(m_tail, other, other.m_head->m_succ, other.m_tail->m_pred, other.m_length);
+				return *this;
+			}
+			ListNode* first = other.m_head->m_succ;
+			ListNode* last = other.m_tail->m_pred;
+			m_head->m_succ = first;
+			first->m_pred = m_head;
+			m_tail->m_pred = last;
+			last->m_succ = m_tail;
 			m_length = other.m_length;
 			other.Reset();
 		}
@@ -820,26 +959,31 @@ public:
 
 public:
 	template<typename T>
-	int Find(T&& data) {
-		ItemType pattern = std::forward<T>(data);
-		for (auto it = begin(); it != end(); it++)
-			if (*it == pattern)
-				return int (it.Index());
+	int Find(const T& data) {
+		int32_t i = 0;
+		for (ListNode* p = m_head->m_succ; p != m_tail; p = p->m_succ, i++) {
+			if (p->m_dataItem == data) {
+				m_finger = p; // subsequent indexed access to the item found costs nothing
+				m_fingerIndex = i;
+				return int(i);
+			}
+		}
 		return -1;
 	}
 
 	//-----------------------------------------------------------------------------
 
 public:
+	// remove the items from .. to (inclusive; 0 means through the last item) and return them as a list
 	List<ItemType> Splice(int32_t from, int32_t to = 0) {
-		ListNode* start = NodePtrAt(int(from), m_headPtr + 1, m_tailPtr - 1);
-		ListNode* end = NodePtrAt(int(to ? to : m_length - 1), m_headPtr + 1, m_tailPtr - 1);
 		List<ItemType> l;
-		if ((start != nullptr) and (end != nullptr)) {
-			for (ListNode* it = start; it != end; it = it->next) {
-				l.Append(new ListNode(it->m_dataItem, it->m_manageData));
-			}
-		}
+		l.m_arena = m_arena;
+		l.ShareNodePool(m_sharedPool);
+		ListNode* first = NodePtrAt(int(from));
+		int32_t firstIndex = m_fingerIndex;
+		ListNode* last = first ? NodePtrAt(int(to ? to : m_length - 1)) : nullptr;
+		if (last and (m_fingerIndex >= firstIndex))
+			l.SpliceRange(l.m_tail, *this, first, last, m_fingerIndex - firstIndex + 1);
 		return l;
 	}
 
@@ -858,12 +1002,80 @@ public:
 	//-----------------------------------------------------------------------------
 
 public:
-	inline bool Remove(ItemType data) {
-		int i = Find(data);
-		if (i < 0)
-			return (m_result = false);
-		Extract(int32_t(i));
-		return (m_result = true);
+	// remove the first item equal to data
+	template<typename T>
+	bool Remove(const T& data) {
+		for (ListNode* p = m_head->m_succ; p != m_tail; p = p->m_succ) {
+			if (p->m_dataItem == data) {
+				ReleaseNode(p);
+				return (m_result = true);
+			}
+		}
+		return (m_result = false);
+	}
+
+	//-----------------------------------------------------------------------------
+	// Position based operations; each acts on the node an iterator refers to in O(1).
+
+	// remove the item at pos and return an iterator to the item following it
+	Iterator Discard(Iterator pos) {
+		ListNode* node = pos.Node();
+		if ((node == m_head) or (node == m_tail))
+			return pos;
+		Iterator succ(node->m_succ.m_nodePtr);
+		ReleaseNode(node);
+		return succ;
+	}
+
+	// move the item at pos out of the list
+	ItemType Extract(Iterator pos) {
+		ListNode* node = pos.Node();
+		if ((node == m_head) or (node == m_tail)) {
+			m_result = false;
+			return *m_none;
+		}
+		ItemType data = std::move(node->m_dataItem);
+		ReleaseNode(node);
+		m_result = true;
+		return data;
+	}
+
+	// insert dataItem in front of pos (end() appends it) and return an iterator to it
+	template<typename T>
+	Iterator InsertBefore(Iterator pos, T&& dataItem, bool manageData = false) {
+		if (pos.Node() == m_head)
+			return end();
+		ListNode* node = AllocNode(std::forward<T>(dataItem), manageData);
+		if (not node)
+			return end();
+		if (pos.Node() != m_tail) // items behind the finger would shift
+			m_finger = nullptr;
+		LinkBefore(pos.Node(), node);
+		m_length++;
+		return Iterator(node);
+	}
+
+	// remove all items predicate returns true for in a single pass
+	template<typename PREDICATE_T>
+	int32_t RemoveIf(PREDICATE_T predicate) {
+		int32_t removed = 0;
+		for (ListNode* p = m_head->m_succ; p != m_tail; ) {
+			ListNode* node = p;
+			p = p->m_succ;
+			if (predicate(node->m_dataItem)) {
+				ReleaseNode(node);
+				++removed;
+			}
+		}
+		return removed;
+	}
+
+	inline bool SpliceRange(Iterator dstPos, List<ItemType>& src, Iterator first, Iterator last, int32_t count = -1) {
+		return SpliceRange(dstPos.Node(), src, first.Node(), last.Node(), count);
+	}
+
+	inline bool SpliceNode(Iterator dstPos, List<ItemType>& src, Iterator pos) {
+		return SpliceRange(dstPos.Node(), src, pos.Node(), pos.Node(), 1);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -876,83 +1088,112 @@ public:
 			ListNode* candidate = nodePtr;
 			nodePtr = nodePtr->Succ();
 			if (filter(*candidate->DataPointer())) {
-				delete candidate;
+				FreeNode(candidate);
 				deleted++;
 			}
 		}
 		m_length -= deleted;
+		if (deleted)
+			m_finger = nullptr;
 		return deleted;
 	}
 
 	//-----------------------------------------------------------------------------
 
-	inline void Swap(ItemType* left, ItemType* right)
+	// Stable bottom-up merge sort, O(n log n) in the worst case. Nodes are relinked; items are
+	// neither copied nor moved, so pointers to them stay valid. Lists cannot be sorted by the
+	// introsort of arrays (quicksort.hpp), which needs random access, but take the same predicates:
+	// less(a, b) returns true if a goes before b, e.g. SortLess or SortGreater.
+	// Sorted runs of 2^k nodes are kept in runs[k] and merged like the digits of a binary counter,
+	// so the sort needs no memory besides the nodes.
+	template<typename LESS_T>
+	void SortBy(LESS_T less)
 	{
-		ItemType h;
-		memcpy(&h, left, sizeof(ItemType));
-		memcpy(left, right, sizeof(ItemType));
-		memcpy(right, &h, sizeof(ItemType));
-		memset(&h, 0, sizeof(ItemType));
+		if (m_length < 2)
+			return;
+		ListNode* runs[32] = {};
+		ListNode* node = m_head->m_succ;
+		m_tail->m_pred->m_succ = nullptr;
+		while (node) {
+			ListNode* run = node;
+			node = node->m_succ;
+			run->m_succ = nullptr;
+			int k = 0;
+			for (; runs[k]; k++) {
+				run = MergeRuns(runs[k], run, less);
+				runs[k] = nullptr;
+			}
+			runs[k] = run;
+		}
+		ListNode* sorted = nullptr;
+		for (int k = 0; k < 32; k++) {
+			if (runs[k])
+				sorted = sorted ? MergeRuns(runs[k], sorted, less) : runs[k];
+		}
+		// restore the predecessor links
+		ListNode* pred = m_head;
+		for (node = sorted; node; node = node->m_succ) {
+			pred->m_succ = node;
+			node->m_pred = pred;
+			pred = node;
+		}
+		pred->m_succ = m_tail;
+		m_tail->m_pred = pred;
+		m_finger = nullptr;
 	}
 
 	//-----------------------------------------------------------------------------
 
-	ItemType& GetMedian(ListNodePtr p, int i) {
-		for (; i; i--)
-			p++;
-		return p->DataValue();
+	// compare(a, b) returns a value < 0, 0 or > 0 like tComparator; direction -1 sorts in descending order
+	template<typename COMPARE_T>
+	void Sort(COMPARE_T compare, int direction = 1)
+	{
+		SortBy(CompareLess<ItemType, COMPARE_T>(compare, direction));
 	}
 
-	//-----------------------------------------------------------------------------
-
-	void Sort(ListNodePtr leftNode, ListNodePtr rightNode, int32_t left, int32_t right, int direction)
+	void SortAscending(tComparator compare)
 	{
-		int32_t		l = left,
-					r = right;
-		ListNodePtr	ln = leftNode,
-					rn = rightNode;
-
-		MemCpy(&m_median, GetMedian(left, (l + r) / 2), sizeof(ItemType));
-		do {
-			while (direction * m_compare(ln->DataPointer(), &m_median) < 0) {
-				++l;
-				++ln;
-			}
-			while (direction * m_compare(rn->DataPointer(), &m_median) > 0) {
-				--r;
-				--rn;
-			}
-			if (l <= r) {
-				if (l < r)
-					Swap(l->DataValue(), r->DataValue());
-				l++;
-				r--;
-			}
-		} while (l <= r);
-		memset(&m_median, 0, sizeof(ItemType));
+		Sort(compare, 1);
+	}
 
-		if (l < right)
-			Sort(ln, rightNode, l, right, direction);
-		if (left < r)
-			Sort(leftNode, rn, left, r, direction);
+	void SortDescending(tComparator compare)
+	{
+		Sort(compare, -1);
 	}
 
-	//-----------------------------------------------------------------------------
+	void SortAscending(void)
+	{
+		SortBy(SortLess());
+	}
 
-	void SortDescending(tComparator compare)
+	void SortDescending(void)
 	{
-		m_compare = compare;
-		Sort(First(), Last(), m_length - 1, -1);
+		SortBy(SortGreater());
 	}
 
 	//-----------------------------------------------------------------------------
 
-	void SortAscending(tComparator compare)
+private:
+	// merge two sorted, nullptr terminated runs linked through m_succ; items of a precede equal
+	// items of b
+	template<typename LESS_T>
+	static ListNode* MergeRuns(ListNode* a, ListNode* b, LESS_T& less)
 	{
-		if (m_length > 1) {
-			m_compare = compare;
-			Sort(m_headPtr->Succ(), m_tailPtr->Pred(), m_length, -1);
+		ListNode* merged = nullptr;
+		ListNode** tail = &merged;
+		while (a and b) {
+			if (less(b->m_dataItem, a->m_dataItem)) {
+				*tail = b;
+				b = b->m_succ;
+			}
+			else {
+				*tail = a;
+				a = a->m_succ;
+			}
+			tail = &(*tail)->m_succ.m_nodePtr;
 		}
+		*tail = a ? a : b;
+		return merged;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -13,6 +13,7 @@
 #include <type_traits>
 
 #include "sharedresource.hpp"
+#include "relocation.hpp"
 
 // =================================================================================================
 
@@ -149,4 +150,10 @@ public:
 
 // =================================================================================================
 
+// a SharedPointer only holds a pointer to its shared handle, so it can be relocated bitwise
+template<typename DATA_T>
+struct is_trivially_relocatable<SharedPointer<DATA_T>> : std::true_type {};
+
+// =================================================================================================
+
 #endif
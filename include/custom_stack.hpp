@@ -9,9 +9,11 @@
 #include "custom_array.hpp"
 
 //-----------------------------------------------------------------------------
+// The elements below the top of stack are in use. Popped elements stay alive in the array (its
+// length is the highest the stack has been) until they are overwritten, so Pop can return a reference.
 
 template < class DATA_T > 
-class Stack : public Array< DATA_T > {
+class Stack : public ManagedArray< DATA_T > {
 	protected:
 		int32_t	m_tos;
 		int32_t	m_growth;	// how much to increase buffer size if the stack is full and something gets pushed on it; -1 = no growth, zero = double capacity every time growth is needed
@@ -41,30 +43,43 @@ class Stack : public Array< DATA_T > {
 		}
 
 
-		inline bool AllowReordering(bool reorder) {
+		inline void AllowReordering(bool reorder) {
 			m_reorder = reorder;
 		}
 
 
 		inline void Init (void) { 
 			m_growth = 0;
+			m_reorder = false;
 			Reset();
-			Array<DATA_T>::Init ();
+			ManagedArray<DATA_T>::Init ();
 			}
 
 
-		inline bool Grow (const int32_t i = 1) {
-			if (m_tos + i >= this->m_info.capacity) {
-				if (not m_growth) {
+		// make room for i more elements
+		inline bool Expand (const int32_t i = 1) {
+			int32_t capacity = this->Capacity();
+			if (m_tos + i > capacity) {
+				if (m_growth < 0) {
 					throw std::runtime_error("stack out of space");
 					return false;
 				}
-				if (not this->Resize(this->m_info.capacity + m_growth)) {
+				capacity = m_growth ? std::max(capacity + m_growth, m_tos + i) : ManagedArray<DATA_T>::GrowCapacity(capacity, m_tos + i);
+				ManagedArray<DATA_T>::Reserve(capacity);
+				if (this->Capacity() < capacity) {
 					throw std::runtime_error("stack expansion failed");
 					return false;
 				}
-				//#pragma omp critical
 			}
+			return true;
+			}
+
+
+		inline bool Grow (const int32_t i = 1) {
+			if (not Expand(i))
+				return false;
+			if (m_tos + i > this->Length())
+				this->Resize(m_tos + i);
 			m_tos += i;
 			return true;
 			}
@@ -72,16 +87,22 @@ class Stack : public Array< DATA_T > {
 		
 		template<typename T>
 		inline bool Push (T&& data) { 
-			if (not Grow ())
-				return false;
-//#pragma omp critical
-			*(this->Data(m_tos - 1)) = std::forward<T>(data);
+			if (m_tos < this->Length())
+				*(this->Data(m_tos)) = std::forward<T>(data);
+			else if (m_tos < this->Capacity())
+				this->Append(std::forward<T>(data));
+			else {
+				DATA_T h(std::forward<T>(data)); // data may be an element of this stack
+				if (not Expand())
+					return false;
+				this->Append(std::move(h));
+			}
+			++m_tos;
 			return true;
 			}
 	
 		
 		inline int32_t Shrink (int32_t i = 1) {
-//#pragma omp critical
 			if (i >= m_tos)
 				m_tos = 0;
 			else
@@ -91,7 +112,6 @@ class Stack : public Array< DATA_T > {
 
 
 		inline DATA_T& Pop (void) {
-//#pragma omp critical
 			return *(this->Data(Shrink()));
 			}
 
@@ -103,25 +123,25 @@ class Stack : public Array< DATA_T > {
 
 
 		inline int32_t Find (DATA_T& data) {
-			for (int32_t i = 0; i < m_tos; i++)
-				if (this->m_data [i] == data)
-					return i;
-			return m_tos;
+			int32_t i = this->Data() ? ArrayFind (this->Data(), m_tos, data) : -1;
+			return (i < 0) ? m_tos : i;
 			}
 
 
 		inline int32_t ToS (void) { return m_tos; }
 
 
-		inline DATA_T* Top (void) { return (this->m_data and m_tos) ? this->m_data + m_tos - 1 : NULL; }
+		inline DATA_T* Top (void) { return (this->Data() and m_tos) ? this->Data() + m_tos - 1 : nullptr; }
 
 
 		inline bool Delete (int32_t i) {
 			if (i >= m_tos) 
 				return false;
-//#pragma omp critical
-			if (i < --m_tos) 
-				memcpy(this->m_data + i, this->m_data + i + 1, sizeof(DATA_T) * (m_tos - i));
+			if (m_reorder and (i < m_tos - 1))
+				this->Data() [i] = std::move(this->Data() [m_tos - 1]);
+			else
+				EraseElement(this->Data(), i, m_tos);
+			--m_tos;
 			return true;
 			}
 
@@ -130,9 +150,8 @@ class Stack : public Array< DATA_T > {
 
 
 		inline DATA_T& Pull (DATA_T& data, int32_t i) {
-//#pragma omp critical
 			if (i < m_tos) {
-				data = this->m_data [i];
+				data = std::move(this->Data() [i]);
 				Delete (i);
 				}
 			return data;
@@ -146,22 +165,21 @@ class Stack : public Array< DATA_T > {
 
 
 		inline DATA_T* GetRef(int32_t i) {
-			//#pragma omp critical
-			return (i < m_tos) ? this->m_data + i : nullptr;
+			return (i < m_tos) ? this->Data() + i : nullptr;
 		}
 
 
 		inline void Destroy (void) {
-			Array<DATA_T>::Destroy ();
+			ManagedArray<DATA_T>::Destroy ();
 			m_tos = 0;
 			}
 
 
 		inline DATA_T *Reserve (int32_t capacity, int32_t growth = 0, bool reorder = false) {
 			Destroy ();
-			m_growth = (static_cast<ptrdiff_t>(growth) < 0) ? 0 : (growth > 0) ? growth : capacity;
+			m_growth = growth;
 			m_reorder = reorder;
-			return Array<DATA_T>::Reserve (capacity);
+			return ManagedArray<DATA_T>::Reserve (capacity);
 			}
 
 
@@ -172,33 +190,95 @@ class Stack : public Array< DATA_T > {
 
 
 		inline void SortAscending (int32_t left = 0, int32_t right = 0) { 
-			if (this->m_data)
-				QuickSort<DATA_T>::SortAscending (this->m_data, left, (right >= 0) ? right : m_tos - 1); 
+			if (this->Data())
+				QuickSort<DATA_T>::SortAscending (this->Data(), left, (right > 0) ? right : m_tos - 1); 
 				}
 
 
 		inline void SortDescending (int32_t left = 0, int32_t right = 0) {
-			if (this->m_data)
-				QuickSort<DATA_T>::SortDescending (this->m_data, left, (right >= 0) ? right : m_tos - 1);
+			if (this->Data())
+				QuickSort<DATA_T>::SortDescending (this->Data(), left, (right > 0) ? right : m_tos - 1);
 			}
 
 
 		inline void SortAscending (QuickSort<DATA_T>::tComparator compare, int32_t left = 0, int32_t right = 0) {
-			if (this->m_data)
-				QuickSort<DATA_T>::SortAscending (this->m_data, left, (right >= 0) ? right : m_tos - 1, compare);
+			if (this->Data())
+				QuickSort<DATA_T>::SortAscending (this->Data(), left, (right > 0) ? right : m_tos - 1, compare);
 			}
 
 
 		inline void SortDescending (QuickSort<DATA_T>::tComparator compare, int32_t left = 0, int32_t right = 0) {
-			if (this->m_data)
-				QuickSort<DATA_T>::SortDescending (this->m_data, left, (right >= 0) ? right : m_tos - 1, compare);
+			if (this->Data())
+				QuickSort<DATA_T>::SortDescending (this->Data(), left, (right > 0) ? right : m_tos - 1, compare);
+			}
+
+
+		template<typename LESS_T>
+		inline void SortBy (LESS_T less, int32_t left = 0, int32_t right = 0) {
+			if (this->Data())
+				QuickSort<DATA_T>::Sort (this->Data(), left, (right > 0) ? right : m_tos - 1, less);
 			}
 
 
 		inline int32_t BinSearch (DATA_T key, int32_t left = 0, int32_t right = 0) {
-			return this->m_data ? QuickSort<DATA_T>::BinSearch (this->m_data, left, (right >= 0) ? right : m_tos - 1, key) : -1;
+			return this->Data() ? QuickSort<DATA_T>::BinSearch (this->Data(), left, (right > 0) ? right : m_tos - 1, key) : -1;
 			}
 
 	};
 
 //-----------------------------------------------------------------------------
+// Stack keeping up to capacity elements inside the stack object (see SmallArray), e.g. for the
+// short explicit stacks of tree traversals.
+
+template < class DATA_T, int32_t capacity >
+class SmallStack : public Stack< DATA_T > {
+	static_assert(capacity > 0, "SmallStack needs inline storage");
+
+	protected:
+		alignas(DATA_T) unsigned char	m_storage[capacity * sizeof(DATA_T)];
+
+	public:
+		SmallStack (int32_t growth = 0, bool reorder = false) {
+			this->SetInlineBuffer (reinterpret_cast<DATA_T*>(m_storage), capacity);
+			this->m_growth = growth;
+			this->m_reorder = reorder;
+			}
+
+
+		SmallStack (const SmallStack& other) : SmallStack () {
+			*this = other;
+			}
+
+
+		SmallStack (SmallStack&& other) : SmallStack () {
+			*this = std::move (other);
+			}
+
+
+		~SmallStack () { this->Destroy (); }
+
+
+		SmallStack& operator= (const SmallStack& other) {
+			if (this != &other) {
+				this->CopyData (other);
+				this->m_tos = other.m_tos;
+				this->m_growth = other.m_growth;
+				this->m_reorder = other.m_reorder;
+				}
+			return *this;
+			}
+
+
+		SmallStack& operator= (SmallStack&& other) {
+			if (this != &other) {
+				this->Move (other);
+				this->m_tos = other.m_tos;
+				this->m_growth = other.m_growth;
+				this->m_reorder = other.m_reorder;
+				other.m_tos = 0;
+				}
+			return *this;
+			}
+	};
+
+//-----------------------------------------------------------------------------
@@ -102,7 +102,7 @@ class String : public SharedArray<char> {
 		}
 
 		void Create(int32_t size) {
-			Reserve(size);
+			Resize(size);
 			*Data() = '\0';
 		}
 
@@ -5,26 +5,36 @@
 #pragma once
 
 #include <new>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <stdint.h>
+#include <stdlib.h>
 
 #include "basicdatapool.hpp"
-#include "avltree.hpp"
 
 // =================================================================================================
+// Keyed data pool with O(1) Claim, FindItem and Release.
+// Items live in the contiguous item storage of BasicDataPool and never move while claimed.
+// Keys are mapped to item indices by an open addressing hash table (linear probing with
+// backward shift deletion, so there are no tombstones to clean up). Unlike DataPool, there
+// is no AVL tree to maintain, and key lookups touch one or two cache lines in the common case.
 
-template <typename KEY_T, typename ITEM_T>
-class DataPool : public BasicDataPool<ITEM_T> {
-
-	using Comparator = typename AVLTreeTraits<KEY_T, int>::Comparator;
-
-	using ItemProcessor = bool(*)(const ITEM_T&);
+template <typename KEY_T, typename ITEM_T, typename HASH_T = std::hash<KEY_T>>
+class FastDataPool : public BasicDataPool<ITEM_T> {
 
 private:
-	AVLTree<KEY_T, int>*	m_usedItems;
-	ItemProcessor			m_itemProcessor;
+	KEY_T*		m_keys;			// key of each claimed item, indexed like the item pool
+	uint8_t*	m_isUsed;		// 1 if the item at the same index is claimed
+	int32_t*	m_slots;		// hash table; item index or -1 for empty slots
+	uint32_t	m_slotMask;		// hash table size - 1; size is a power of two
+	int32_t		m_itemCount;
+	int32_t		m_highWater;	// one past the highest item index ever claimed; bounds WalkItems
+	HASH_T		m_hash;
 
 public:
 	FastDataPool()
-		: m_itemPool(nullptr), m_freeItems(nullptr), m_usedItems(nullptr), m_freeItemCount(0), m_isCreated(false)
+		: BasicDataPool<ITEM_T>(), m_keys(nullptr), m_isUsed(nullptr), m_slots(nullptr), m_slotMask(0), m_itemCount(0), m_highWater(0)
 	{
 	}
 
@@ -34,77 +44,154 @@ public:
 	}
 
 
-	bool Setup(int capacity, bool createOnce, Comparator comparator) {
-		if (createOnce and m_isCreated)
+private:
+	bool Setup(int32_t capacity, bool createOnce) {
+		if (capacity <= 0)
+			return false;
+		if (createOnce and this->m_isCreated)
 			return true;
-		if (!this->DataPool::Setup(capacity, createOnce))
+		// BasicDataPool::Setup only releases the item storage, not the key and hash tables
+		Destroy();
+		if (not this->BasicDataPool<ITEM_T>::Setup(capacity, createOnce))
+			return false;
+		// keep the load factor at or below 0.5 so that probe sequences stay short
+		uint32_t slotCount = 1;
+		while (slotCount < uint32_t(capacity) * 2)
+			slotCount <<= 1;
+		m_keys = new (std::nothrow) KEY_T[capacity];
+		m_isUsed = reinterpret_cast<uint8_t*>(calloc(capacity, sizeof(*m_isUsed)));
+		m_slots = reinterpret_cast<int32_t*>(malloc(slotCount * sizeof(*m_slots)));
+		if (not (m_keys and m_isUsed and m_slots)) {
+			Destroy();
 			return false;
-		if (!(m_usedItems = new AVLTree<KEY_T, int>(capacity, comparator))) {
-			
+		}
+		for (uint32_t i = 0; i < slotCount; i++)
+			m_slots[i] = -1;
+		m_slotMask = slotCount - 1;
+		m_itemCount = 0;
+		m_highWater = 0;
+		return true;
+	}
+
+
+	inline uint32_t HomeSlot(const KEY_T& key) const {
+		// mix the hash so that identity hashes of aligned addresses spread over the table
+		uint64_t h = uint64_t(m_hash(key)) * 0x9E3779B97F4A7C15ull;
+		return uint32_t(h >> 32) & m_slotMask;
+	}
+
+
+	// returns the table slot holding key, or the empty slot where it would have to be inserted
+	inline uint32_t FindSlot(const KEY_T& key) const {
+		uint32_t slot = HomeSlot(key);
+		for (;;) {
+			int32_t itemIndex = m_slots[slot];
+			if ((itemIndex < 0) or (m_keys[itemIndex] == key))
+				return slot;
+			slot = (slot + 1) & m_slotMask;
+		}
+	}
+
 
+	// remove the entry in slot and shift following entries of the same probe chain back
+	void EraseSlot(uint32_t slot) {
+		uint32_t hole = slot;
+		for (uint32_t next = (hole + 1) & m_slotMask; m_slots[next] >= 0; next = (next + 1) & m_slotMask) {
+			uint32_t home = HomeSlot(m_keys[m_slots[next]]);
+			// move the entry into the hole unless its home slot lies cyclically in (hole, next]
+			if (((next - home) & m_slotMask) >= ((next - hole) & m_slotMask)) {
+				m_slots[hole] = m_slots[next];
+				hole = next;
+			}
+		}
+		m_slots[hole] = -1;
 	}
 
 
-	inline bool Create(int capacity, bool createOnce = true, Comparator comparator = nullptr) {
-		return m_isCreated = Setup(capacity, createOnce);
+public:
+	inline bool Create(int32_t capacity, bool createOnce = true) {
+		return this->m_isCreated = Setup(capacity, createOnce);
 	}
 
 
 	void Destroy(void) {
-		delete m_usedItems;
-		m_usedItems = nullptr;
-		this->DataPool::Destroy();
+		if (m_keys) {
+			delete[] m_keys;
+			m_keys = nullptr;
+		}
+		if (m_isUsed) {
+			free(m_isUsed);
+			m_isUsed = nullptr;
+		}
+		if (m_slots) {
+			free(m_slots);
+			m_slots = nullptr;
+		}
+		m_slotMask = 0;
+		m_itemCount = 0;
+		m_highWater = 0;
+		this->BasicDataPool<ITEM_T>::Destroy();
 	}
 
 
-	ITEM_T* FindItem(KEY_T key) {
-		if (!m_usedItems)
-			return nullptr;
-		int i;
-		if (!m_usedItems->Extract(key, i))
+	ITEM_T* FindItem(const KEY_T& key) {
+		if (not m_slots)
 			return nullptr;
-		return m_itemPool + i;
+		int32_t itemIndex = m_slots[FindSlot(key)];
+		return (itemIndex < 0) ? nullptr : this->m_itemPool + itemIndex;
 	}
 
 
-
+	// claim an item for key; returns the existing item if key is already in use
 	ITEM_T* Claim(const KEY_T& key) {
-		if (!m_usedItems)
-			return nullptr;
-		if (!m_freeItemCount)
+		if (not m_slots)
 			return nullptr;
-		ITEM_T* item = Claim(&i);
-		if (!item)
+		uint32_t slot = FindSlot(key);
+		if (m_slots[slot] >= 0)
+			return this->m_itemPool + m_slots[slot];
+		int itemIndex;
+		ITEM_T* item = this->BasicDataPool<ITEM_T>::Claim(itemIndex);
+		if (not item)
 			return nullptr;
-		m_usedItems.Insert(key, i);
+		m_keys[itemIndex] = key;
+		m_isUsed[itemIndex] = 1;
+		m_slots[slot] = itemIndex;
+		if (itemIndex >= m_highWater)
+			m_highWater = itemIndex + 1;
+		++m_itemCount;
 		return item;
 	}
 
 
-	void Release(const KEY_T& key) {
-		if (m_usedItems) {
-			int i;
-			if (m_usedItems->Extract(key, i))
-				this->DataPool::Release(i);
-		}
-	}
-
-
-	bool AvlNodeProcessor(const int& i) {
-		m_itemProcessor(m_itemPool[i]);
+	ITEM_T* Release(const KEY_T& key) {
+		if (not m_slots)
+			return nullptr;
+		uint32_t slot = FindSlot(key);
+		int32_t itemIndex = m_slots[slot];
+		if (itemIndex < 0)
+			return nullptr;
+		EraseSlot(slot);
+		m_isUsed[itemIndex] = 0;
+		--m_itemCount;
+		return this->BasicDataPool<ITEM_T>::Release(itemIndex);
 	}
 
 
-	bool AvlNodeProcessor(const int& i) {
-		m_itemProcessor(m_itemPool[i]);
+	inline int32_t ItemCount(void) const {
+		return m_itemCount;
 	}
 
 
-	bool WalkItems(ItemProcessor processor) {
-		m_itemProcessor = processor;
-		return m_usedItems ? m_usedItems->Walk(AvlNodeProcessor) : false;
+	// Call processor(key, item) for each claimed item in item storage order.
+	// processor returns false to stop the walk; WalkItems then returns false, too.
+	template <typename PROCESSOR_T>
+	bool WalkItems(PROCESSOR_T&& processor) {
+		for (int32_t i = 0; i < m_highWater; i++) {
+			if (m_isUsed[i] and not processor(const_cast<const KEY_T&>(m_keys[i]), this->m_itemPool[i]))
+				return false;
+		}
+		return true;
 	}
-	};
-
+};
 
 // =================================================================================================
@@ -0,0 +1,76 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =================================================================================================
+// A file mapped into the address space. Opening a file only sets up the mapping; its pages are read
+// from the file (or the page cache) when they are first touched, so opening even huge files is fast.
+// - ReadOnly: the mapping cannot be written to; writing crashes the program.
+// - CopyOnWrite: the mapping can be written to, but the changes stay private to the process and are
+//   never written back to the file. Only the pages written to use memory of their own.
+// Empty files are opened successfully, but have no address.
+
+class MappedFile {
+public:
+	enum class Mode : uint8_t {
+		ReadOnly,
+		CopyOnWrite
+	};
+
+	// access pattern hints for the paging system
+	enum class Access : uint8_t {
+		Normal,
+		Sequential,	// read ahead aggressively, drop pages soon after they have been read
+		Random,		// do not read ahead
+		WillNeed	// start reading the pages in now
+	};
+
+private:
+	void*	m_address = nullptr;
+	size_t	m_size = 0;
+	Mode	m_mode = Mode::ReadOnly;
+	bool	m_isOpen = false;
+
+public:
+	MappedFile() = default;
+
+	~MappedFile() {
+		Close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* filename, Mode mode = Mode::ReadOnly);
+
+	void Close(void);
+
+	// hint how [offset, offset + size) will be accessed; size 0 means up to the end of the file
+	bool Advise(Access access, size_t offset = 0, size_t size = 0);
+
+	inline void* GetAddress(void) const {
+		return m_address;
+	}
+
+	inline size_t Size(void) const {
+		return m_size;
+	}
+
+	inline Mode GetMode(void) const {
+		return m_mode;
+	}
+
+	inline bool IsOpen(void) const {
+		return m_isOpen;
+	}
+
+	// replace the contents of filename by size bytes at data, e.g. to create a file for mapping
+	static bool Write(const char* filename, const void* data, size_t size);
+};
+
+// =================================================================================================
@@ -3,25 +3,203 @@
 #include "std_defines.h"
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
 
 #include "type_helper.hpp"
-#include "datapool.hpp"
+#include "fastdatapool.hpp"
+#include "allocationprofiler.h"
+#include "arenamemory.h"
 
 // =================================================================================================
 
+// Descriptors are kept per arena region (a size class slab or a large block) and for external
+// buffers registered with SetPtr, not per allocation. Blocks find their region's descriptor
+// through the descriptor index in their BlockHeader.
+
 class MemoryDescriptor {
 public:
 	using Address = char*;
 
 	Address	address;
-	int32_t	size;
+	int32_t	size;		// slabs: bytes carved into blocks; large blocks and external buffers: requested size
+	int32_t	blockSize;	// size of the region, including block headers and guard bytes
+	int16_t	sizeClass;	// size class of a slab; -1 for large blocks
 	bool	isManaged;
+	int32_t	liveCount;	// slabs: blocks handed out, including those held by thread caches
 
 	MemoryDescriptor()
-		: address(nullptr), size(0), isManaged(true)
+		: address(nullptr), size(0), blockSize(0), sizeClass(-1), isManaged(true), liveCount(0)
 	{ }
 };
 
+// =================================================================================================
+// In-band header preceding each block handed out by the MemoryManager. Free and Realloc find it by
+// subtracting its size from the block address, so looking up a block is pointer arithmetic instead
+// of a search. The guard is checked on each Free; a second guard follows the caller's data.
+// The header is 16 bytes, so blocks stay 16 byte aligned.
+
+#define BLOCK_GUARD		"@#@#"
+#define GUARD_SIZE		4
+
+class BlockHeader {
+public:
+	using Address = char*;
+
+	static const uint16_t isLive = 1;		// block is handed out
+	static const uint16_t isSampled = 2;	// allocation was recorded by the profiler
+
+	uint32_t	descriptorIndex;	// descriptor of the slab or large block holding the block
+	uint32_t	size;				// requested size
+	int16_t		sizeClass;			// -1 for large blocks
+	uint16_t	flags;
+	char		guard[GUARD_SIZE];
+
+	inline Address Data(void) {
+		return reinterpret_cast<Address>(this + 1);
+	}
+
+	inline bool IsIntact(void) const {
+		return not memcmp(guard, BLOCK_GUARD, GUARD_SIZE);
+	}
+
+	inline bool IsLive(void) const {
+		return (flags & isLive) != 0;
+	}
+
+	static inline BlockHeader* Of(void* address) {
+		return reinterpret_cast<BlockHeader*>(address) - 1;
+	}
+
+	// free blocks are linked through their data so that the header stays intact while they are free
+	static inline Address& Link(Address block) {
+		return *reinterpret_cast<Address*>(block + sizeof(BlockHeader));
+	}
+};
+
+static_assert(sizeof(BlockHeader) == 16, "BlockHeader must keep blocks 16 byte aligned");
+
+// =================================================================================================
+// Blocks of up to MAX_CLASS_SIZE bytes are served from size classes. Classes are 16 bytes apart
+// up to 128 bytes and four per power of two above that. Each class carves its blocks from
+// slabs taken from the arena and keeps released blocks on its own free list, so allocating and
+// releasing a small block is O(1) and memory is recycled instead of growing the arena.
+// A slab none of whose blocks is in use any more is returned to the arena like a large block, as
+// long as its class keeps at least a slab's worth of other free blocks; that costs a pass over the
+// class's free list, which the slack keeps rare for classes whose usage goes up and down.
+// Larger blocks are carved from the arena directly and kept on an address ordered first fit
+// free list when released, where they are merged with adjacent free blocks. They are split
+// if the remainder is big enough to serve another large block.
+
+#define SIZE_CLASS_COUNT	44
+#define MAX_CLASS_SIZE		65536
+#define MIN_SLAB_SIZE		(256 * 1024)
+
+class SizeClass {
+public:
+	using Address = char*;
+
+	Address	freeBlocks;		// singly linked list of released blocks; see BlockHeader::Link
+	Address	slabCursor;		// next uncarved block in the current slab
+	Address	slabEnd;
+	uint32_t	slabDescriptor;	// region descriptor of the current slab
+	int32_t	blockSize;
+	int32_t	slabSize;
+	int32_t	batchSize;		// number of blocks exchanged with thread caches at once
+	int32_t	slabCount;
+	int32_t	usedBlockCount;
+	int32_t	freeBlockCount;
+
+	SizeClass()
+		: freeBlocks(nullptr), slabCursor(nullptr), slabEnd(nullptr), slabDescriptor(0), blockSize(0), slabSize(0), batchSize(0), slabCount(0), usedBlockCount(0), freeBlockCount(0)
+	{ }
+};
+
+
+// =================================================================================================
+// Per thread cache of size class blocks. Blocks are popped and pushed without locking and are
+// exchanged with the central size classes in batches. A block released by another thread than
+// the one that allocated it goes to the releasing thread's cache; since size classes are shared,
+// that is all cross thread frees need. A cache is flushed to the size classes when its thread exits.
+// Re-creating the MemoryManager replaces its arena; caches filled before that are discarded when
+// their thread next uses the manager, since their blocks belong to the old arena.
+
+class ThreadCache {
+public:
+	using Address = char*;
+
+	class ClassCache {
+	public:
+		Address	blocks = nullptr;	// singly linked like SizeClass::freeBlocks
+		int32_t	count = 0;
+	};
+
+	ClassCache	m_classCaches[SIZE_CLASS_COUNT];
+	uint32_t	m_epoch = 0;		// MemoryManager::m_epoch when the cache was filled
+
+	// false once the thread's cache has been flushed. Not a member: a store to a member in the
+	// destructor may be optimized away, since the object's lifetime ends with it.
+	static thread_local bool	m_isAlive;
+
+	~ThreadCache();
+
+	inline Address Pop(int classIndex) {
+		ClassCache& cc = m_classCaches[classIndex];
+		Address address = cc.blocks;
+		if (address) {
+			cc.blocks = BlockHeader::Link(address);
+			--cc.count;
+		}
+		return address;
+	}
+
+	inline int32_t Push(Address address, int classIndex) {
+		ClassCache& cc = m_classCaches[classIndex];
+		BlockHeader::Link(address) = cc.blocks;
+		cc.blocks = address;
+		return ++cc.count;
+	}
+
+	// forget all cached blocks without touching them
+	inline void Discard(void) {
+		for (ClassCache& cc : m_classCaches)
+			cc = ClassCache();
+	}
+};
+
+// =================================================================================================
+
+class FreeBlock {
+public:
+	FreeBlock*	next;
+	FreeBlock*	prev;
+	size_t		size;
+};
+
+
+class MemoryStatistics {
+public:
+	size_t	arenaSize;			// size of the arena
+	size_t	committedHighWater;	// most bytes of the arena committed so far, including decommitted ones
+	size_t	reservedBytes;		// bytes taken from the arena for slabs and large blocks
+	size_t	requestedBytes;		// bytes currently requested by callers
+	size_t	classUsedBytes;		// bytes in size class blocks handed out
+	size_t	classFreeBytes;		// bytes in released size class blocks
+	size_t	largeUsedBytes;		// bytes in large blocks handed out
+	size_t	largeFreeBytes;		// bytes in released large blocks and slabs
+	int32_t	largeUsedCount;
+	int32_t	largeFreeCount;
+	size_t	reallocInPlace;		// reallocations that grew or shrank the block in place
+	size_t	reallocMoved;		// reallocations that had to move the data to a new block
+	float	fragmentation;		// share of reserved arena bytes not holding requested data
+
+	MemoryStatistics() {
+		memset(this, 0, sizeof(*this));
+	}
+};
+
 // =================================================================================================
 
 class MemoryManager {
@@ -29,20 +207,49 @@ public:
 	using Address = char*;
 	using Key = ptrdiff_t;
 
-	//DataPool<Address, MemoryDescriptor>	m_memoryDescriptors;
+	ArenaMemory	m_arena;
 	Address		memoryPool = nullptr;
 	Address		memoryStart = nullptr, memoryEnd = nullptr;
 	bool		allocFromStart = false;
-	Key			m_key;
 
-	DataPool<Key, MemoryDescriptor>	m_memoryDescriptors;
+	BasicDataPool<MemoryDescriptor>		m_regions;			// descriptors of slabs and large blocks
+	int32_t								m_regionCount = 0;	// one past the highest region descriptor index ever claimed
+	bool								m_isDestroyed = false;	// descriptors are gone; later frees are ignored and claims fail
+	std::atomic<uint32_t>				m_epoch = 0;		// counts Create calls; tells thread caches of earlier arenas apart
+	FastDataPool<Key, MemoryDescriptor>	m_externalBlocks;	// buffers registered with SetPtr
+
+	SizeClass	m_sizeClasses[SIZE_CLASS_COUNT];
+	FreeBlock*	m_largeBlocks = nullptr;
+	size_t		m_largeUsedBytes = 0;
+	size_t		m_largeFreeBytes = 0;
+	int32_t		m_largeUsedCount = 0;
+	int32_t		m_largeFreeCount = 0;
+
+	std::atomic<size_t>	m_requestedBytes = 0;
+	std::atomic<size_t>	m_reallocInPlace = 0;
+	std::atomic<size_t>	m_reallocMoved = 0;
+
+	// Integrity sweeps check block headers and guards of all blocks in a range of regions.
+	// CheckIntegrity sweeps all regions. When m_sweepInterval is set, every m_sweepInterval-th
+	// locked operation additionally sweeps the next m_sweepSize regions. Sweeps are a debug aid:
+	// they read headers of blocks other threads may be handing out or releasing at the same time.
+	int32_t		m_sweepInterval = 0;
+	int32_t		m_sweepSize = 0;
+	int32_t		m_sweepCountdown = 0;
+	int32_t		m_sweepCursor = 0;
+
+	AllocationProfiler	m_profiler;
+
+	// guards regions, size classes, large blocks and the arena; thread caches work without it
+	std::mutex	m_lock;
+
+	static thread_local ThreadCache	m_threadCache;
 
 public:
 #if 1
 	MemoryManager()
-		: m_memoryDescriptors()
+		: m_regions(), m_externalBlocks()
 	{ 
-		InitializeAnyType(m_key);
 	}
 
 	~MemoryManager() {
@@ -52,42 +259,105 @@ public:
 
 	Address Reserve(uint32_t size);
 
-	static int KeyComparer(void* context, const Key& searchKey, const Key& dataKey) {
-		return (searchKey < dataKey) ? -1 : (searchKey > dataKey) ? 1 : 0;
+	bool Create(int capacity, bool createOnce = true, const ArenaOptions& arenaOptions = ArenaOptions());
+
+	void SetupSizeClasses(void);
+
+	static int SizeClassIndex(uint32_t size);
+
+	static int32_t SizeClassSize(int classIndex);
+
+	Address ClaimBlock(int classIndex);
+
+	void ReleaseBlock(Address address, int classIndex);
+
+	Address FillCache(ThreadCache& cache, int classIndex);
+
+	void DrainCache(ThreadCache& cache, int classIndex, int32_t count);
+
+	void FlushCache(ThreadCache& cache);
+
+	// the calling thread's cache, emptied first if it holds blocks of an earlier arena
+	inline ThreadCache& CurrentCache(void) {
+		uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+		if (m_threadCache.m_epoch != epoch) {
+			m_threadCache.Discard();
+			m_threadCache.m_epoch = epoch;
+		}
+		return m_threadCache;
 	}
 
-	bool Create(int capacity, bool createOnce = true);
+	Address TakeFreeMemory(uint32_t& blockSize);
 
-	void Destroy(void);
+	Address ClaimLargeBlock(uint32_t& blockSize);
+
+	void ReleaseSlab(int classIndex, uint32_t descriptorIndex);
+
+	void ReleaseLargeBlock(Address address, size_t blockSize);
+
+	void UnlinkLargeBlock(FreeBlock* fb);
+
+	MemoryDescriptor* ClaimRegion(Address address, int32_t regionSize, int classIndex, uint32_t& descriptorIndex);
+
+	void ReleaseRegion(uint32_t descriptorIndex);
 
-	bool IsIntact(int itemIndex);
+	void GetStatistics(MemoryStatistics& stats);
+
+	const SizeClass& GetSizeClass(int classIndex) {
+		return m_sizeClasses[classIndex];
+	}
+
+	void PrintStatistics(FILE* stream = stderr);
+
+	void Destroy(void);
 
-	bool IsIntact(MemoryDescriptor& md);
+	bool IsIntact(BlockHeader* header);
 
-	bool IsAddress(int itemIndex);
+	bool IsIntact(int32_t descriptorIndex);
 
-	static bool ItemProcessor(void* context, const Key& key, const int& itemIndex);
-		
-	static bool ItemFinder(void* context, const Key& key, const int& itemIndex);
+	bool CheckRegions(int32_t first, int32_t count);
 
 	bool CheckIntegrity(void);
 
-	MemoryDescriptor* Claim(uint32_t size);
+	void SetIntegrityChecks(int32_t interval, int32_t sweepSize);
 
-	void* Alloc(uint32_t size);
+	Address Claim(uint32_t size, void* caller);
+
+	// caller is the call site reported by the profiler; defaults to the caller of Alloc
+	void* Alloc(uint32_t size, void* caller = nullptr);
 
 	void* Realloc(void* address, uint32_t size, bool bCopy);
 
+	bool ResizeLargeBlock(BlockHeader* header, uint32_t size);
+
+	void ReleaseLarge(BlockHeader* header);
+
+	void ReleaseExternal(void* address);
+
 	void Free(void* address);
 
 	void* SetPtr(void* address, uint32_t size);
 
+	// sample every sampleInterval-th allocation per thread; on POSIX systems, SIGUSR2 writes a report to reportPath
+	bool StartProfiler(int32_t sampleInterval, const char* reportPath = nullptr);
+
+	// other threads must not be allocating while the profiler is stopped
+	void StopProfiler(void);
+
+	inline AllocationProfiler& Profiler(void) {
+		return m_profiler;
+	}
+
 	inline Key ToKey(void* address) {
-		return Key(ptrdiff_t(Address(address) - memoryPool) & 0xFFFFFFF);
+		return Key(Address(address) - memoryPool);
+	}
+
+	inline bool IsArenaAddress(void* address) {
+		return (Address(address) >= memoryPool) and (Address(address) < memoryEnd);
 	}
 
 	inline MemoryDescriptor* GetDataPool() {
-		return m_memoryDescriptors.GetDataPool();
+		return m_regions.GetDataPool();
 	}
 
 	static MemoryManager& Instance() {
@@ -96,8 +366,16 @@ public:
 	}
 
 private:
-	inline MemoryDescriptor* Find(Key key) {
-		return m_memoryDescriptors.FindItem(key);
+	// m_lock must be held
+	inline void SampleIntegrity(void) {
+		if (m_sweepInterval and not --m_sweepCountdown) {
+			m_sweepCountdown = m_sweepInterval;
+			if (m_sweepCursor >= m_regionCount)
+				m_sweepCursor = 0;
+			int32_t count = std::min(m_sweepSize, m_regionCount - m_sweepCursor);
+			CheckRegions(m_sweepCursor, count);
+			m_sweepCursor += count;
+		}
 	}
 
 	//MemoryManager() = default;
@@ -0,0 +1,214 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================================================
+// Monotonic (bump pointer) arena. Memory is carved from chunks by advancing a cursor, the same way
+// MemoryManager::Reserve carves its arena, and is never released individually. Rewind releases
+// everything allocated after a marker at once; the chunks are kept for reuse, so a steady state
+// workload does not touch the heap at all. Destructors of objects placed in the arena are not
+// run by the arena; containers using it run them when they release their items.
+// The arena is not thread safe; use one arena per thread.
+
+class MonotonicArena {
+public:
+	using Address = char*;
+
+	class Chunk {
+	public:
+		Chunk*	next;		// next older chunk
+		size_t	size;		// size of the chunk's data area
+		size_t	serial;		// changes whenever the chunk is (re)used; tells markers of earlier uses apart
+
+		inline Address Data(void) {
+			return reinterpret_cast<Address>(this + 1);
+		}
+	};
+
+	class Marker {
+	public:
+		Chunk*	chunk = nullptr;
+		Address	cursor = nullptr;
+		size_t	serial = 0;
+	};
+
+private:
+	Chunk*	m_chunks = nullptr;		// chunk currently carved from, followed by the older ones
+	Chunk*	m_spareChunks = nullptr;	// chunks released by Rewind
+	Address	m_cursor = nullptr;
+	Address	m_end = nullptr;
+	size_t	m_chunkSize;
+	size_t	m_reservedBytes = 0;	// size of all chunks taken from the heap
+	size_t	m_chunkSerial = 0;
+
+public:
+	explicit MonotonicArena(size_t chunkSize = 64 * 1024)
+		: m_chunkSize(chunkSize)
+	{ }
+
+	~MonotonicArena() {
+		Destroy();
+	}
+
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+
+	inline void* Alloc(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		Address p = reinterpret_cast<Address>((uintptr_t(m_cursor) + alignment - 1) & ~uintptr_t(alignment - 1));
+		if (not m_cursor or (p + size > m_end))
+			return AllocChunk(size, alignment);
+		m_cursor = p + size;
+		return p;
+	}
+
+
+	template <typename DATA_T, typename... ARGS>
+	inline DATA_T* New(ARGS&&... args) {
+		void* p = Alloc(sizeof(DATA_T), alignof(DATA_T));
+		return p ? new (p) DATA_T(std::forward<ARGS>(args)...) : nullptr;
+	}
+
+
+	template <typename DATA_T>
+	DATA_T* NewArray(size_t count) {
+		DATA_T* p = reinterpret_cast<DATA_T*>(Alloc(count * sizeof(DATA_T), alignof(DATA_T)));
+		if (p) {
+			if constexpr (std::is_trivially_constructible<DATA_T>::value)
+				memset(p, 0, count * sizeof(DATA_T));
+			else {
+				for (size_t i = 0; i < count; i++)
+					new (p + i) DATA_T();
+			}
+		}
+		return p;
+	}
+
+
+	inline Marker Mark(void) const {
+		return Marker{ m_chunks, m_cursor, m_chunks ? m_chunks->serial : 0 };
+	}
+
+
+	// False if marker's chunk has been released (or released and reused) or the cursor is already
+	// below marker, which happens to the markers of scopes ending out of order.
+	bool IsCurrent(const Marker& marker) const {
+		if (not marker.chunk)
+			return true;
+		for (Chunk* chunk = m_chunks; chunk; chunk = chunk->next) {
+			if (chunk == marker.chunk)
+				return (chunk->serial == marker.serial) and ((chunk != m_chunks) or (marker.cursor <= m_cursor));
+		}
+		return false;
+	}
+
+
+	// release everything allocated after marker was taken; markers that are no longer current are ignored
+	void Rewind(const Marker& marker) {
+		if (not IsCurrent(marker))
+			return;
+		while (m_chunks != marker.chunk) {
+			Chunk* chunk = m_chunks;
+			m_chunks = chunk->next;
+			chunk->next = m_spareChunks;
+			m_spareChunks = chunk;
+		}
+		if (m_chunks) {
+			m_cursor = marker.cursor;
+			m_end = m_chunks->Data() + m_chunks->size;
+		}
+		else
+			m_cursor = m_end = nullptr;
+	}
+
+
+	inline void Reset(void) {
+		Rewind(Marker());
+	}
+
+
+	// return all chunks to the heap
+	void Destroy(void) {
+		Reset();
+		while (m_spareChunks) {
+			Chunk* chunk = m_spareChunks;
+			m_spareChunks = chunk->next;
+			free(chunk);
+		}
+		m_reservedBytes = 0;
+	}
+
+
+	inline size_t ReservedBytes(void) const {
+		return m_reservedBytes;
+	}
+
+private:
+	// continue in a spare chunk or a new one that is big enough
+	void* AllocChunk(size_t size, size_t alignment) {
+		size_t required = size + alignment;
+		Chunk* chunk = m_spareChunks;
+		Chunk* prev = nullptr;
+		for (; chunk and (chunk->size < required); chunk = chunk->next)
+			prev = chunk;
+		if (chunk) {
+			if (prev)
+				prev->next = chunk->next;
+			else
+				m_spareChunks = chunk->next;
+		}
+		else {
+			size_t chunkSize = std::max(m_chunkSize, required);
+			chunk = reinterpret_cast<Chunk*>(malloc(sizeof(Chunk) + chunkSize));
+			if (not chunk)
+				return nullptr;
+			chunk->size = chunkSize;
+			m_reservedBytes += sizeof(Chunk) + chunkSize;
+		}
+		chunk->serial = ++m_chunkSerial;
+		chunk->next = m_chunks;
+		m_chunks = chunk;
+		m_cursor = chunk->Data();
+		m_end = m_cursor + chunk->size;
+		return Alloc(size, alignment);
+	}
+};
+
+// =================================================================================================
+// Releases everything allocated from arena during the scope's lifetime when it goes out of scope.
+// Containers using the arena must not outlive the scope.
+
+class ArenaScope {
+private:
+	MonotonicArena&			m_arena;
+	MonotonicArena::Marker	m_marker;
+
+public:
+	explicit ArenaScope(MonotonicArena& arena)
+		: m_arena(arena), m_marker(arena.Mark())
+	{ }
+
+	~ArenaScope() {
+		m_arena.Rewind(m_marker);
+	}
+
+	inline MonotonicArena& Arena(void) {
+		return m_arena;
+	}
+
+	ArenaScope(const ArenaScope&) = delete;
+	ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+// =================================================================================================
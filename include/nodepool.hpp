@@ -0,0 +1,185 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
+
+// =================================================================================================
+// Growable pool of equally sized nodes. Nodes are carved from chunks taken from the heap; released
+// nodes are put on a free list and handed out again before a new chunk is taken, so a container
+// with a steady number of nodes does not touch the heap at all. Chunks grow geometrically from
+// chunkCapacity to maxChunkCapacity nodes and are only returned to the heap by Destroy.
+// A pool may be shared by several containers of the same node type. The containers using a pool
+// other than their own register with it (AddUser), so its owner can check that none of them is
+// left when it destroys the pool; a pool with users cannot be merged into another one either.
+// It is not thread safe.
+
+template <typename NODE_T>
+class NodePool {
+private:
+	union Slot {
+		Slot*	next;		// next free slot
+		alignas(NODE_T) char node[sizeof(NODE_T)];
+	};
+
+	class Chunk {
+	public:
+		Chunk*	next;
+		int32_t	capacity;
+
+		inline Slot* Slots(void) {
+			return reinterpret_cast<Slot*>(reinterpret_cast<char*>(this) + SlotOffset());
+		}
+
+		static constexpr size_t SlotOffset(void) {
+			return (sizeof(Chunk) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+		}
+	};
+
+	Chunk*	m_chunks = nullptr;
+	Slot*	m_freeSlots = nullptr;
+	int32_t	m_chunkCapacity;		// node count of the next chunk
+	int32_t	m_maxChunkCapacity;
+	int32_t	m_nodeCount = 0;		// nodes in all chunks
+	int32_t	m_freeCount = 0;		// nodes on the free list
+	int32_t	m_userCount = 0;		// containers using the pool besides its owner
+
+public:
+	explicit NodePool(int32_t chunkCapacity = 8, int32_t maxChunkCapacity = 1024)
+		: m_chunkCapacity(std::max(chunkCapacity, 1)), m_maxChunkCapacity(std::max(maxChunkCapacity, chunkCapacity))
+	{ }
+
+	~NodePool() {
+		Destroy();
+	}
+
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+
+
+	inline void* Alloc(void) {
+		if (not m_freeSlots and not AllocChunk())
+			return nullptr;
+		Slot* slot = m_freeSlots;
+		m_freeSlots = slot->next;
+		--m_freeCount;
+		return slot;
+	}
+
+
+	inline void Free(void* node) {
+		Slot* slot = reinterpret_cast<Slot*>(node);
+		slot->next = m_freeSlots;
+		m_freeSlots = slot;
+		++m_freeCount;
+	}
+
+
+	template <typename... ARGS>
+	inline NODE_T* New(ARGS&&... args) {
+		void* p = Alloc();
+		return p ? new (p) NODE_T(std::forward<ARGS>(args)...) : nullptr;
+	}
+
+
+	inline void Delete(NODE_T* node) {
+		node->~NODE_T();
+		Free(node);
+	}
+
+
+	// take over all chunks of other; other's nodes (live or free) then belong to this pool. Fails if
+	// other has users, since their nodes would then live in chunks other no longer knows about.
+	bool Merge(NodePool& other) {
+		if (&other == this)
+			return true;
+		if (other.m_userCount)
+			return false;
+		if (other.m_chunks) {
+			Chunk* last = other.m_chunks;
+			while (last->next)
+				last = last->next;
+			last->next = m_chunks;
+			m_chunks = other.m_chunks;
+		}
+		if (other.m_freeSlots) {
+			Slot* last = other.m_freeSlots;
+			while (last->next)
+				last = last->next;
+			last->next = m_freeSlots;
+			m_freeSlots = other.m_freeSlots;
+		}
+		m_nodeCount += other.m_nodeCount;
+		m_freeCount += other.m_freeCount;
+		m_chunkCapacity = std::max(m_chunkCapacity, other.m_chunkCapacity);
+		other.m_chunks = nullptr;
+		other.m_freeSlots = nullptr;
+		other.m_nodeCount =
+		other.m_freeCount = 0;
+		return true;
+	}
+
+
+	// return all chunks to the heap. No node of the pool may be in use any more.
+	void Destroy(void) {
+		while (m_chunks) {
+			Chunk* chunk = m_chunks;
+			m_chunks = chunk->next;
+			free(chunk);
+		}
+		m_freeSlots = nullptr;
+		m_nodeCount =
+		m_freeCount = 0;
+	}
+
+
+	inline void AddUser(void) {
+		++m_userCount;
+	}
+
+
+	inline void RemoveUser(void) {
+		--m_userCount;
+	}
+
+
+	inline int32_t UserCount(void) const {
+		return m_userCount;
+	}
+
+
+	inline int32_t NodeCount(void) const {
+		return m_nodeCount;
+	}
+
+	inline int32_t FreeCount(void) const {
+		return m_freeCount;
+	}
+
+private:
+	bool AllocChunk(void) {
+		Chunk* chunk = reinterpret_cast<Chunk*>(malloc(Chunk::SlotOffset() + size_t(m_chunkCapacity) * sizeof(Slot)));
+		if (not chunk)
+			return false;
+		chunk->next = m_chunks;
+		chunk->capacity = m_chunkCapacity;
+		m_chunks = chunk;
+		Slot* slots = chunk->Slots();
+		for (int32_t i = chunk->capacity - 1; i >= 0; i--) {
+			slots[i].next = m_freeSlots;
+			m_freeSlots = slots + i;
+		}
+		m_nodeCount += chunk->capacity;
+		m_freeCount += chunk->capacity;
+		m_chunkCapacity = std::min(2 * m_chunkCapacity, m_maxChunkCapacity);
+		return true;
+	}
+};
+
+// =================================================================================================
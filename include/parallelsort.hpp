@@ -0,0 +1,153 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+#include <stdint.h>
+
+#include "quicksort.hpp"
+#include "relocation.hpp"
+#include "threadpool.h"
+
+//-----------------------------------------------------------------------------
+// Parallel merge sort for large arrays. The array is cut into a power of two of chunks, at least
+// as many as the pool has threads, which are sorted in parallel (by introsort, or by a stable sort
+// if stable is set). The sorted chunks are then merged pairwise in log2(chunks) rounds between the
+// array and a buffer of the same size. Every merge is split into independent segments at the same
+// ranks of its output (merge path), so all threads work in every round, including the last one.
+// Merging relocates the elements (see RelocateElements), so the buffer is raw storage and DATA_T
+// needs no default constructor; after each round, only the merge target holds live elements.
+// The result only depends on the number of threads of the pool; with stable set, equal elements
+// keep their order, so it does not depend on anything.
+// Arrays too small to be worth the buffer and the threads are sorted sequentially.
+
+template < typename DATA_T, typename LESS_T >
+class ParallelMergeSort {
+	public:
+		static constexpr int32_t MIN_CHUNK_SIZE = 1 << 15;
+		static constexpr int32_t SEGMENTS_PER_THREAD = 4;
+
+//-----------------------------------------------------------------------------
+
+static void Sort (DATA_T* data, int32_t count, LESS_T less, bool stable, ThreadPool& pool = ThreadPool::Instance ())
+{
+	int32_t chunks = 1;
+	while ((chunks < pool.ThreadCount ()) and (count / (2 * chunks) >= MIN_CHUNK_SIZE))
+		chunks *= 2;
+	if (chunks == 1) {
+		SortChunk (data, 0, count, less, stable);
+		return;
+	}
+	int32_t segmentCount = pool.ThreadCount () * SEGMENTS_PER_THREAD;
+	DATA_T* buffer = reinterpret_cast<DATA_T*> (::operator new (size_t (count) * sizeof (DATA_T), std::align_val_t (alignof (DATA_T)), std::nothrow));
+	// a round has at most max (segmentCount, chunks / 2) segments, plus one end per merge
+	std::unique_ptr<int32_t[]> splits (new (std::nothrow) int32_t [segmentCount + chunks]);
+	if (not (buffer and splits)) {
+		::operator delete (buffer, std::align_val_t (alignof (DATA_T)));
+		SortChunk (data, 0, count, less, stable);
+		return;
+	}
+
+	pool.ParallelFor (chunks, [&](int32_t i) {
+		SortChunk (data, ChunkStart (i, chunks, count), ChunkStart (i + 1, chunks, count), less, stable);
+		});
+
+	DATA_T* source = data;
+	DATA_T* dest = buffer;
+	for (int32_t width = 1; width < chunks; width *= 2) {
+		// merge runs of width chunks into runs of 2 * width chunks. All segment ends are found
+		// before any segment is merged, since merging ends the elements' life in source.
+		int32_t merges = chunks / (2 * width);
+		int32_t segments = std::max (segmentCount / merges, 1);
+		// merge m takes the runs [start, mid) and [mid, end)
+		auto runs = [&](int32_t m, int32_t& start, int32_t& mid, int32_t& end) {
+			start = ChunkStart (2 * m * width, chunks, count);
+			mid = ChunkStart ((2 * m + 1) * width, chunks, count);
+			end = ChunkStart ((2 * m + 2) * width, chunks, count);
+			};
+		pool.ParallelFor (merges * (segments + 1), [&](int32_t task) {
+			int32_t start, mid, end;
+			runs (task / (segments + 1), start, mid, end);
+			int32_t rank = ChunkStart (task % (segments + 1), segments, end - start);
+			splits [task] = CoRank (source + start, mid - start, source + mid, end - mid, rank, less);
+			});
+		pool.ParallelFor (merges * segments, [&](int32_t task) {
+			int32_t start, mid, end;
+			int32_t m = task / segments;
+			int32_t s = task % segments;
+			runs (m, start, mid, end);
+			int32_t* split = splits.get () + m * (segments + 1) + s;
+			MergeSegment (source + start, source + mid, dest + start,
+						  ChunkStart (s, segments, end - start), split [0], ChunkStart (s + 1, segments, end - start), split [1], less);
+			});
+		std::swap (source, dest);
+	}
+	if (source != data) {
+		pool.ParallelFor (segmentCount, [&](int32_t s) {
+			int32_t start = ChunkStart (s, segmentCount, count);
+			RelocateElements (data + start, source + start, ChunkStart (s + 1, segmentCount, count) - start);
+			});
+	}
+	::operator delete (buffer, std::align_val_t (alignof (DATA_T)));
+}
+
+//-----------------------------------------------------------------------------
+
+private:
+	static inline int32_t ChunkStart (int32_t i, int32_t chunks, int32_t count)
+	{
+		return int32_t (int64_t (count) * i / chunks);
+	}
+
+
+	static void SortChunk (DATA_T* data, int32_t start, int32_t end, LESS_T& less, bool stable)
+	{
+		if (stable)
+			std::stable_sort (data + start, data + end, less);
+		else
+			IntroSort<DATA_T, LESS_T>::Sort (data, start, end - 1, less);
+	}
+
+
+	// Number of elements of a among the first rank elements of the stable merge of a and b, in which
+	// elements of a go before equal elements of b.
+	static int32_t CoRank (const DATA_T* a, int32_t aLength, const DATA_T* b, int32_t bLength, int32_t rank, LESS_T& less)
+	{
+		int32_t lo = std::max (rank - bLength, 0);
+		int32_t hi = std::min (rank, aLength);
+		while (lo < hi) {
+			int32_t i = lo + (hi - lo) / 2;
+			// b [rank - i - 1] goes before a [i] unless a [i] does not go after it
+			if (not less (b [rank - i - 1], a [i]))
+				lo = i + 1;
+			else
+				hi = i;
+		}
+		return lo;
+	}
+
+
+	// Relocate the output elements [from, to) of the stable merge of a and b to the raw storage at
+	// dest + from. i and iEnd are the co-ranks of from and to in a.
+	static void MergeSegment (DATA_T* a, DATA_T* b, DATA_T* dest, int32_t from, int32_t i, int32_t to, int32_t iEnd, LESS_T& less)
+	{
+		int32_t j = from - i;
+		int32_t jEnd = to - iEnd;
+		dest += from;
+		while ((i < iEnd) and (j < jEnd)) {
+			if (less (b [j], a [i]))
+				RelocateElements (dest++, b + j++, 1);
+			else
+				RelocateElements (dest++, a + i++, 1);
+		}
+		RelocateElements (dest, a + i, iEnd - i);
+		RelocateElements (dest + (iEnd - i), b + j, jEnd - j);
+	}
+};
+
+//-----------------------------------------------------------------------------
@@ -9,162 +9,236 @@
 #endif
 
 #include <stdexcept>
+#include <utility>
+#include "relocation.hpp"
 
 //-----------------------------------------------------------------------------
+// Sort order predicates: less(a, b) is true if a goes before b. Predicates are passed by type, so
+// the compiler can inline them into the sort loops.
 
-template < typename DATA_T > 
-class QuickSort {
+class SortLess {
 	public:
-		typedef int (__cdecl *tComparator) (const DATA_T*, const DATA_T*);
+		template <typename T>
+		inline bool operator() (const T& a, const T& b) const { return a < b; }
+};
 
-		template<typename KEY_T>
-		using tSearchComparator = int(__cdecl*)(const DATA_T&, const KEY_T&);
 
-		// holds a copy of the median data for sorting; one global variable should work 
-		// as it is only used during the sorting part and not during the recursive descent
-		tComparator	m_compare;
-		DATA_T		m_median;
+class SortGreater {
+	public:
+		template <typename T>
+		inline bool operator() (const T& a, const T& b) const { return b < a; }
+};
+
+
+// turns a comparison function returning a value < 0, 0 or > 0 into a predicate; direction -1
+// reverses the order
+template < typename DATA_T, typename COMPARE_T = int (__cdecl *) (const DATA_T*, const DATA_T*) >
+class CompareLess {
+	public:
+		COMPARE_T	m_compare;
+		int			m_direction;
+
+		explicit CompareLess (COMPARE_T compare, int direction = 1) : m_compare (compare), m_direction (direction) {}
+
+		inline bool operator() (const DATA_T& a, const DATA_T& b) const { return m_direction * m_compare (&a, &b) < 0; }
+};
+
+//-----------------------------------------------------------------------------
+// Introsort: quicksort with a ninther (median of three medians of three) or median of three pivot
+// and Hoare partitioning, which splits runs of equal elements evenly. Ranges of up to
+// INSERTION_SORT_SIZE elements are finished by insertion sort, and ranges the quicksort has split
+// badly too often fall back to heapsort, so sorting takes O(n log n) time in the worst case.
+// The smaller part of a partition is sorted recursively and the larger one iteratively, limiting
+// the stack depth to O(log n). The pivot stays in place while partitioning and is never copied.
+// Not stable: equal elements may change their order.
+
+template < typename DATA_T, typename LESS_T >
+class IntroSort {
+	public:
+		static constexpr int32_t INSERTION_SORT_SIZE = 16;
+		static constexpr int32_t NINTHER_SIZE = 128;
 
 //-----------------------------------------------------------------------------
 
-inline void Swap(DATA_T* left, DATA_T* right)
+static void Sort (DATA_T* data, int32_t left, int32_t right, LESS_T& less)
 {
-	DATA_T h;
-	memcpy (&h, left, sizeof (DATA_T));
-	memcpy(left, right, sizeof(DATA_T));
-	memcpy(right, &h, sizeof(DATA_T));
-	memset(&h, 0, sizeof(DATA_T));
+	if (right <= left)
+		return;
+	int32_t depthLimit = 0;
+	for (int32_t n = right - left + 1; n > 1; n >>= 1)
+		depthLimit += 2;
+	Sort (data, left, right, less, depthLimit);
 }
 
 //-----------------------------------------------------------------------------
 
-void SortAscending(DATA_T* data, int32_t left, int32_t right)
+static void Sort (DATA_T* data, int32_t left, int32_t right, LESS_T& less, int32_t depthLimit)
 {
-	int32_t	l = left,
-			r = right;
-	DATA_T*	m = new DATA_T(data [(l + r) / 2]);
-
-	do {
-		while (data[l] < *m)
-			l++;
-		while (data[r] > *m)
-			r--;
-		if (l <= r) {
-			if (l < r)
-				Swap(data + l, data + r);
-			l++;
-			r--;
+	while (right - left >= INSERTION_SORT_SIZE) {
+		if (depthLimit-- == 0) {
+			HeapSort (data + left, right - left + 1, less);
+			return;
 		}
-	} while (l <= r);
-	memset(&m_median, 0, sizeof(DATA_T));
-
-	if (l < right)
-		SortAscending(data, l, right);
-	if (left < r)
-		SortAscending(data, left, r);
+		int32_t m = Partition (data, left, right, less);
+		if (m - left < right - m) {
+			Sort (data, left, m - 1, less, depthLimit);
+			left = m + 1;
+		}
+		else {
+			Sort (data, m + 1, right, less, depthLimit);
+			right = m - 1;
+		}
+	}
+	InsertionSort (data, left, right, less);
 }
 
 //-----------------------------------------------------------------------------
 
-void SortDescending(DATA_T* data, int32_t left, int32_t right)
+static void InsertionSort (DATA_T* data, int32_t left, int32_t right, LESS_T& less)
 {
-	int32_t	l = left,
-			r = right;
+	for (int32_t i = left + 1; i <= right; i++) {
+		if (not less (data [i], data [i - 1]))
+			continue;
+		DATA_T h (std::move (data [i]));
+		int32_t j = i;
+		do {
+			data [j] = std::move (data [j - 1]);
+		} while ((--j > left) and less (h, data [j - 1]));
+		data [j] = std::move (h);
+	}
+}
 
-	memcpy(&m_median, data + (l + r) / 2, sizeof(DATA_T));
-	do {
-		while (data[l] > m_median)
-			l++;
-		while (data[r] < m_median)
-			r--;
-		if (l <= r) {
-			if (l < r)
-				Swap(data + l, data + r);
-			l++;
-			r--;
-		}
-	} while (l <= r);
-	memset(&m_median, 0, sizeof(DATA_T));
+//-----------------------------------------------------------------------------
 
-	if (l < right)
-		SortDescending(data, l, right);
-	if (left < r)
-		SortDescending(data, left, r);
+static void HeapSort (DATA_T* data, int32_t count, LESS_T& less)
+{
+	for (int32_t i = count / 2 - 1; i >= 0; i--)
+		SiftDown (data, i, count, less);
+	for (int32_t i = count - 1; i > 0; i--) {
+		SwapElements (data [0], data [i]);
+		SiftDown (data, 0, i, less);
+	}
 }
 
 //-----------------------------------------------------------------------------
 
-void Sort(DATA_T* data, int32_t left, int32_t right, int direction)
+static void SiftDown (DATA_T* data, int32_t i, int32_t count, LESS_T& less)
 {
-	int32_t	l = left,
-			r = right;
-	
-	// flat copy to avoid any complicated copy operations; data only needed to have a fixed median value
-	memcpy(&m_median, data + (l + r) / 2, sizeof(DATA_T)); 
-	do {
-		while (direction * m_compare(data + l, &m_median) > 0)
-			l++;
-		while (direction * m_compare(data + r, &m_median) < 0)
-			r--;
-		if (l <= r) {
-			if (l < r)
-				Swap(data + l, data + r);
-			l++;
-			r--;
-		}
-	} while (l <= r);
-	// make sure m_median doesn't contain any d'tors
-	memset(&m_median, 0, sizeof(DATA_T)); 
+	for (;;) {
+		int32_t child = 2 * i + 1;
+		if (child >= count)
+			return;
+		if ((child + 1 < count) and less (data [child], data [child + 1]))
+			++child;
+		if (not less (data [i], data [child]))
+			return;
+		SwapElements (data [i], data [child]);
+		i = child;
+	}
+}
 
-	if (l < right)
-		Sort(data, l, right, direction);
-	if (left < r)
-		Sort(data, left, r, direction);
+//-----------------------------------------------------------------------------
+// index of the median of data [a], data [b] and data [c]
+
+static inline int32_t Median (DATA_T* data, int32_t a, int32_t b, int32_t c, LESS_T& less)
+{
+	if (less (data [a], data [b]))
+		return less (data [b], data [c]) ? b : less (data [a], data [c]) ? c : a;
+	return less (data [a], data [c]) ? a : less (data [b], data [c]) ? c : b;
 }
 
 //-----------------------------------------------------------------------------
+// Move a pivot to its final place m, with no element of [left, m - 1] going after it and no element
+// of [m + 1, right] going before it. Returns m.
 
-void SortDescending(DATA_T* data, int32_t left, int32_t right, tComparator compare)
+static int32_t Partition (DATA_T* data, int32_t left, int32_t right, LESS_T& less)
 {
-	if (right - left > 1) {
-		m_compare = compare;
-		Sort(data, left, right, 1);
+	int32_t n = right - left + 1;
+	int32_t mid = left + n / 2;
+	int32_t pivot;
+	if (n < NINTHER_SIZE)
+		pivot = Median (data, left, mid, right, less);
+	else {
+		int32_t d = n / 8;
+		pivot = Median (data,
+						Median (data, left, left + d, left + 2 * d, less),
+						Median (data, mid - d, mid, mid + d, less),
+						Median (data, right - 2 * d, right - d, right, less),
+						less);
 	}
+	// keep the pivot at the front, where the scans do not move it
+	if (pivot != left)
+		SwapElements (data [left], data [pivot]);
+	const DATA_T& p = data [left];
+	int32_t l = left;
+	int32_t r = right + 1;
+	for (;;) {
+		// the pivot itself stops the right scan, an element not less than the pivot (if any) the left one
+		do
+			++l;
+		while ((l <= right) and less (data [l], p));
+		do
+			--r;
+		while (less (p, data [r]));
+		if (l >= r)
+			break;
+		SwapElements (data [l], data [r]);
+	}
+	// data [r] does not go after the pivot: swap them to put the pivot between the parts
+	if (r != left)
+		SwapElements (data [left], data [r]);
+	return r;
 }
 
+};
+
 //-----------------------------------------------------------------------------
 
-void SortAscending(DATA_T* data, int32_t left, int32_t right, tComparator compare)
+template < typename DATA_T >
+class QuickSort {
+	public:
+		typedef int (__cdecl *tComparator) (const DATA_T*, const DATA_T*);
+
+		template<typename KEY_T>
+		using tSearchComparator = int(__cdecl*)(const DATA_T&, const KEY_T&);
+
+//-----------------------------------------------------------------------------
+// sort data [left] through data [right] so that less (data [i], data [j]) is false for all i > j
+
+template < typename LESS_T >
+static inline void Sort (DATA_T* data, int32_t left, int32_t right, LESS_T less)
 {
-	if (right - left > 1) {
-		m_compare = compare;
-		Sort(data, left, right, -1);
-	}
+	IntroSort<DATA_T, LESS_T>::Sort (data, left, right, less);
 }
 
-// ----------------------------------------------------------------------------
-/*
-template<typename KEY_T>
-int32_t BinSearch(const DATA_T* data, int32_t l, int32_t r, typename KEY_T::KeyType key) 
+//-----------------------------------------------------------------------------
+
+static inline void SortAscending (DATA_T* data, int32_t left, int32_t right)
 {
-	int32_t	m;
+	Sort (data, left, right, SortLess ());
+}
 
-	do {
-		m = (l + r) / 2;
-		if (data[m] > key)
-			r = m - 1;
-		else if (data[m] < key)
-			l = m + 1;
-		else {
-			// find first record with equal key
-			while ((m > 0) and (data[m - 1] > key))
-				--m;
-			return m;
-		}
-	} while (l <= r);
-	return -1;
+//-----------------------------------------------------------------------------
+
+static inline void SortDescending (DATA_T* data, int32_t left, int32_t right)
+{
+	Sort (data, left, right, SortGreater ());
 }
-*/
+
+//-----------------------------------------------------------------------------
+
+static inline void SortAscending (DATA_T* data, int32_t left, int32_t right, tComparator compare)
+{
+	Sort (data, left, right, CompareLess<DATA_T> (compare, 1));
+}
+
+//-----------------------------------------------------------------------------
+
+static inline void SortDescending (DATA_T* data, int32_t left, int32_t right, tComparator compare)
+{
+	Sort (data, left, right, CompareLess<DATA_T> (compare, -1));
+}
+
 // ----------------------------------------------------------------------------
 
 template<typename KEY_T>
@@ -0,0 +1,83 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+// =================================================================================================
+// Relocating container elements: moving them to other storage and ending their life at the old
+// place. A trivially relocatable type can be relocated by copying its bytes, which is a lot cheaper
+// than a move construction followed by destroying the source. Trivially copyable types are, and so
+// are types that only refer to their resources through pointers, like SharedPointer; such types opt
+// in by specializing is_trivially_relocatable. Types pointing into themselves (e.g. String with its
+// inline short string buffer, or List with its embedded sentinels) must not.
+
+template <typename T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+// -------------------------------------------------------------------------------------------------
+// Move count live elements from source to uninitialized storage at dest; the elements at source are
+// dead afterwards. The ranges must not overlap.
+
+template <typename T>
+inline void RelocateElements(T* dest, T* source, int32_t count) {
+	if (count <= 0)
+		return;
+	if constexpr (is_trivially_relocatable_v<T>)
+		memcpy(static_cast<void*>(dest), static_cast<const void*>(source), size_t(count) * sizeof(T));
+	else {
+		for (T* end = source + count; source < end; ++source, ++dest) {
+			new (dest) T(std::move(*source));
+			source->~T();
+		}
+	}
+}
+
+// -------------------------------------------------------------------------------------------------
+// Remove element i of count live elements by moving the elements behind it one place to the front.
+// The last place keeps a live element, which holds a default value afterwards.
+
+template <typename T>
+inline void EraseElement(T* data, int32_t i, int32_t count) {
+	if ((i < 0) or (i >= count))
+		return;
+	if constexpr (is_trivially_relocatable_v<T>) {
+		if constexpr (not std::is_trivially_copyable_v<T>)
+			data[i].~T();
+		memmove(static_cast<void*>(data + i), static_cast<const void*>(data + i + 1), size_t(count - i - 1) * sizeof(T));
+		if constexpr (not std::is_trivially_copyable_v<T>)
+			new (data + count - 1) T();
+	}
+	else {
+		std::move(data + i + 1, data + count, data + i);
+		data[count - 1] = T(); // release what the moved-from element still holds
+	}
+}
+
+// -------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline void SwapElements(T& a, T& b) {
+	if constexpr (is_trivially_relocatable_v<T>) {
+		alignas(T) unsigned char h[sizeof(T)];
+		memcpy(h, static_cast<const void*>(&a), sizeof(T));
+		memcpy(static_cast<void*>(&a), static_cast<const void*>(&b), sizeof(T));
+		memcpy(static_cast<void*>(&b), h, sizeof(T));
+	}
+	else {
+		using std::swap;
+		swap(a, b);
+	}
+}
+
+// =================================================================================================
@@ -1,7 +1,504 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
 #pragma once
 
-#include "list.hpp"
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <type_traits>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================================================
+// Unrolled linked list. Each segment holds up to segmentLength items in a small array, so
+// iterating is almost as fast as iterating an array and the per item overhead of the links is
+// spread over the segment. Inserting and removing items in the middle of the list moves at most
+// one segment's items: full segments are split in half, and a segment is merged with its successor
+// when both together fill at most half a segment. Indexed access walks segments instead of items.
+// Pointers to items are invalidated when items are inserted into or removed from their segment.
 
 template <typename ITEM_T>
-using SegmentedList = List<ITEM_T>;
+class SegmentedList
+{
+public:
+	using ItemType = ITEM_T;
+
+	class Segment {
+	public:
+		Segment*	m_pred;
+		Segment*	m_succ;
+		int32_t		m_length;
+
+		inline ItemType* Items(void) {
+			return reinterpret_cast<ItemType*>(reinterpret_cast<char*>(this) + ItemOffset());
+		}
+
+		static constexpr size_t ItemOffset(void) {
+			return (sizeof(Segment) + alignof(ItemType) - 1) / alignof(ItemType) * alignof(ItemType);
+		}
+	};
+
+	//----------------------------------------
+
+	class Iterator {
+	private:
+		Segment*	m_segment;
+		int32_t		m_index;	// index of the current item in its segment
+
+	public:
+		explicit Iterator(Segment* segment = nullptr, int32_t index = 0)
+			: m_segment(segment), m_index(index)
+		{ }
+
+		operator bool() const {
+			return m_segment != nullptr;
+		}
+
+		inline ItemType& operator*() const {
+			return m_segment->Items()[m_index];
+		}
+
+		inline ItemType* operator->() const {
+			return m_segment->Items() + m_index;
+		}
+
+		inline Iterator& operator++() {
+			if (++m_index == m_segment->m_length) {
+				m_segment = m_segment->m_succ;
+				m_index = 0;
+			}
+			return *this;
+		}
+
+		inline Iterator operator++(int) {
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		inline bool operator==(const Iterator& other) const {
+			return (m_segment == other.m_segment) and (m_index == other.m_index);
+		}
+
+		inline bool operator!=(const Iterator& other) const {
+			return not (*this == other);
+		}
+	};
+
+	//----------------------------------------
+
+protected:
+	const char*	m_name;
+	Segment*	m_first;
+	Segment*	m_last;
+	Segment*	m_spare;			// last released segment, kept to avoid heap churn at segment boundaries
+	ItemType*	m_none;
+	int32_t		m_segmentLength;
+	int32_t		m_segmentCount;
+	int32_t		m_length;
+	bool		m_result;
+
+public:
+	// segmentLength 0 sizes segments to about 512 bytes of items
+	SegmentedList(const char* name = "", int32_t segmentLength = 0)
+		: m_name(name), m_first(nullptr), m_last(nullptr), m_spare(nullptr), m_none(nullptr),
+		  m_segmentLength(DefaultSegmentLength(segmentLength)), m_segmentCount(0), m_length(0), m_result(true)
+	{
+		Init();
+	}
+
+	SegmentedList(SegmentedList<ItemType> const& other)
+		: SegmentedList(other.m_name, other.m_segmentLength)
+	{
+		Copy(other);
+	}
+
+	SegmentedList(SegmentedList<ItemType>&& other) noexcept
+		: SegmentedList(other.m_name, other.m_segmentLength)
+	{
+		Move(other);
+	}
+
+	SegmentedList(std::initializer_list<ItemType> data, int32_t segmentLength = 0)
+		: SegmentedList("", segmentLength)
+	{
+		for (auto const& d : data)
+			Append(d);
+	}
+
+	~SegmentedList() {
+		Destroy();
+		delete m_none;
+	}
+
+	inline SegmentedList<ItemType>& operator= (SegmentedList<ItemType> const& other) {
+		if (&other != this) {
+			Clear();
+			Copy(other);
+		}
+		return *this;
+	}
+
+	inline SegmentedList<ItemType>& operator= (SegmentedList<ItemType>&& other) noexcept {
+		return Move(other);
+	}
+
+	inline SegmentedList<ItemType>& operator= (std::initializer_list<ItemType> data) {
+		Clear();
+		for (auto const& d : data)
+			Append(d);
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+
+	inline void Init(void) {
+		if (not m_none)
+			m_none = new ItemType();
+	}
+
+	// release all items; one segment is kept for reuse
+	void Clear(void) {
+		while (m_first) {
+			Segment* segment = m_first;
+			m_first = segment->m_succ;
+			DestroyItems(segment->Items(), segment->m_length);
+			FreeSegment(segment);
+		}
+		m_last = nullptr;
+		m_segmentCount = 0;
+		m_length = 0;
+	}
+
+	void Destroy(void) {
+		Clear();
+		if (m_spare) {
+			free(m_spare);
+			m_spare = nullptr;
+		}
+	}
+
+	SegmentedList<ItemType>& Copy(const SegmentedList<ItemType>& other) {
+		for (auto const& d : other)
+			Append(d);
+		return *this;
+	}
+
+	// move the other list to this list; will leave the other list empty
+	SegmentedList<ItemType>& Move(SegmentedList<ItemType>& other) {
+		if (&other != this) {
+			Destroy();
+			std::swap(m_first, other.m_first);
+			std::swap(m_last, other.m_last);
+			std::swap(m_spare, other.m_spare);
+			std::swap(m_segmentCount, other.m_segmentCount);
+			std::swap(m_length, other.m_length);
+			m_segmentLength = other.m_segmentLength;
+		}
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+
+	inline Iterator begin() const {
+		return Iterator(m_first, 0);
+	}
+
+	inline Iterator end() const {
+		return Iterator(nullptr, 0);
+	}
+
+	inline int32_t Length(void) const {
+		return m_length;
+	}
+
+	inline bool IsEmpty(void) const {
+		return m_length == 0;
+	}
+
+	inline int32_t SegmentLength(void) const {
+		return m_segmentLength;
+	}
+
+	inline int32_t SegmentCount(void) const {
+		return m_segmentCount;
+	}
+
+	inline bool Result(void) const {
+		return m_result;
+	}
+
+	inline ItemType& operator[] (int32_t i) {
+		Segment* segment = Locate(i);
+		if (not segment) {
+			m_result = false;
+			return *m_none;
+		}
+		m_result = true;
+		return segment->Items()[i];
+	}
+
+	//-----------------------------------------------------------------------------
+	// insert dataItem in front of the i-th item; -1 appends it
+
+	template<typename T>
+	ItemType* Insert(int32_t i, T&& dataItem) {
+		Segment* segment;
+		if ((i == -1) or (i == m_length)) {
+			segment = m_last;
+			if (not segment or (segment->m_length == m_segmentLength)) {
+				if (not (segment = AllocSegment()))
+					return Fail();
+				LinkAfter(segment, m_last);
+			}
+			i = segment->m_length;
+		}
+		else {
+			if (not (segment = Locate(i)))
+				return Fail();
+			if (segment->m_length == m_segmentLength) {
+				Segment* successor = AllocSegment();
+				if (not successor)
+					return Fail();
+				LinkAfter(successor, segment);
+				int32_t half = segment->m_length / 2;
+				successor->m_length = segment->m_length - half;
+				RelocateItems(successor->Items(), segment->Items() + half, successor->m_length);
+				segment->m_length = half;
+				if (i > half) {
+					i -= half;
+					segment = successor;
+				}
+			}
+		}
+		ItemType* items = segment->Items();
+		if (i == segment->m_length)
+			new (items + i) ItemType(std::forward<T>(dataItem));
+		else {
+			new (items + segment->m_length) ItemType(std::move(items[segment->m_length - 1]));
+			for (int32_t j = segment->m_length - 1; j > i; j--)
+				items[j] = std::move(items[j - 1]);
+			items[i] = std::forward<T>(dataItem);
+		}
+		++segment->m_length;
+		++m_length;
+		m_result = true;
+		return items + i;
+	}
+
+	template<typename T>
+	inline ItemType* Append(T&& dataItem) {
+		return Insert(-1, std::forward<T>(dataItem));
+	}
+
+	//-----------------------------------------------------------------------------
+
+	ItemType Extract(int32_t i) {
+		Segment* segment = Locate(i);
+		if (not segment) {
+			m_result = false;
+			return *m_none;
+		}
+		ItemType data = std::move(segment->Items()[i]);
+		RemoveAt(segment, i);
+		m_result = true;
+		return data;
+	}
+
+	bool Extract(ItemType& data, int32_t i) {
+		Segment* segment = Locate(i);
+		if (not segment)
+			return m_result = false;
+		data = std::move(segment->Items()[i]);
+		RemoveAt(segment, i);
+		return m_result = true;
+	}
+
+	bool Discard(int32_t i) {
+		Segment* segment = Locate(i);
+		if (not segment)
+			return m_result = false;
+		RemoveAt(segment, i);
+		return m_result = true;
+	}
+
+	//-----------------------------------------------------------------------------
+
+	SegmentedList<ItemType>& operator+= (const SegmentedList<ItemType>& other) {
+		return Copy(other);
+	}
+
+	template<typename T>
+	int32_t Find(T&& data) const {
+		int32_t index = 0;
+		for (Segment* segment = m_first; segment; segment = segment->m_succ) {
+			ItemType* items = segment->Items();
+			for (int32_t i = 0; i < segment->m_length; i++)
+				if (items[i] == data)
+					return index + i;
+			index += segment->m_length;
+		}
+		return -1;
+	}
+
+	inline bool Remove(const ItemType& data) {
+		int32_t i = Find(data);
+		return (i < 0) ? (m_result = false) : Discard(i);
+	}
+
+	// remove all items filter returns true for, compacting each segment in a single pass
+	template<typename FILTER_T>
+	int32_t Filter(FILTER_T filter) {
+		int32_t deleted = 0;
+		for (Segment* segment = m_first; segment; ) {
+			ItemType* items = segment->Items();
+			int32_t kept = 0;
+			for (int32_t i = 0; i < segment->m_length; i++) {
+				if (filter(items[i]))
+					continue;
+				if (kept != i)
+					items[kept] = std::move(items[i]);
+				++kept;
+			}
+			DestroyItems(items + kept, segment->m_length - kept);
+			deleted += segment->m_length - kept;
+			m_length -= segment->m_length - kept;
+			segment->m_length = kept;
+			Segment* successor = segment->m_succ;
+			if (not kept) {
+				Unlink(segment);
+				FreeSegment(segment);
+			}
+			segment = successor;
+		}
+		return deleted;
+	}
+
+	//-----------------------------------------------------------------------------
+
+private:
+	static int32_t DefaultSegmentLength(int32_t segmentLength) {
+		if (segmentLength > 1)
+			return segmentLength;
+		return std::clamp(int32_t(512 / sizeof(ItemType)), 4, 64);
+	}
+
+	inline ItemType* Fail(void) {
+		m_result = false;
+		return nullptr;
+	}
+
+	// find the segment holding the i-th item (negative i counts from the end) and turn i into
+	// the item's index in that segment
+	Segment* Locate(int32_t& i) const {
+		if (i < 0)
+			i += m_length;
+		if ((i < 0) or (i >= m_length))
+			return nullptr;
+		if (i < m_length / 2) {
+			Segment* segment = m_first;
+			for (; i >= segment->m_length; segment = segment->m_succ)
+				i -= segment->m_length;
+			return segment;
+		}
+		i = m_length - i; // distance from the end of the list
+		Segment* segment = m_last;
+		for (; i > segment->m_length; segment = segment->m_pred)
+			i -= segment->m_length;
+		i = segment->m_length - i;
+		return segment;
+	}
+
+	void RemoveAt(Segment* segment, int32_t i) {
+		ItemType* items = segment->Items();
+		for (int32_t j = i + 1; j < segment->m_length; j++)
+			items[j - 1] = std::move(items[j]);
+		items[--segment->m_length].~ItemType();
+		--m_length;
+		if (not segment->m_length) {
+			Unlink(segment);
+			FreeSegment(segment);
+		}
+		else {
+			Segment* successor = segment->m_succ;
+			if (successor and (segment->m_length + successor->m_length <= m_segmentLength / 2)) {
+				RelocateItems(items + segment->m_length, successor->Items(), successor->m_length);
+				segment->m_length += successor->m_length;
+				Unlink(successor);
+				FreeSegment(successor);
+			}
+		}
+	}
+
+	// move count items to uninitialized memory at dest, destroying the sources
+	static void RelocateItems(ItemType* dest, ItemType* src, int32_t count) {
+		if constexpr (std::is_trivially_copyable<ItemType>::value)
+			memcpy(dest, src, size_t(count) * sizeof(ItemType));
+		else {
+			for (int32_t i = 0; i < count; i++) {
+				new (dest + i) ItemType(std::move(src[i]));
+				src[i].~ItemType();
+			}
+		}
+	}
+
+	static void DestroyItems(ItemType* items, int32_t count) {
+		if constexpr (not std::is_trivially_destructible<ItemType>::value) {
+			for (int32_t i = 0; i < count; i++)
+				items[i].~ItemType();
+		}
+	}
+
+	Segment* AllocSegment(void) {
+		Segment* segment = m_spare;
+		if (segment)
+			m_spare = nullptr;
+		else if (not (segment = reinterpret_cast<Segment*>(malloc(Segment::ItemOffset() + size_t(m_segmentLength) * sizeof(ItemType)))))
+			return nullptr;
+		segment->m_pred =
+		segment->m_succ = nullptr;
+		segment->m_length = 0;
+		return segment;
+	}
+
+	// the segment's items must have been destroyed or moved
+	void FreeSegment(Segment* segment) {
+		if (m_spare)
+			free(segment);
+		else
+			m_spare = segment;
+	}
+
+	// link segment behind pred; nullptr makes it the first segment
+	void LinkAfter(Segment* segment, Segment* pred) {
+		segment->m_pred = pred;
+		segment->m_succ = pred ? pred->m_succ : m_first;
+		if (segment->m_succ)
+			segment->m_succ->m_pred = segment;
+		else
+			m_last = segment;
+		if (pred)
+			pred->m_succ = segment;
+		else
+			m_first = segment;
+		++m_segmentCount;
+	}
+
+	void Unlink(Segment* segment) {
+		if (segment->m_pred)
+			segment->m_pred->m_succ = segment->m_succ;
+		else
+			m_first = segment->m_succ;
+		if (segment->m_succ)
+			segment->m_succ->m_pred = segment->m_pred;
+		else
+			m_last = segment->m_pred;
+		--m_segmentCount;
+	}
+};
 
+// =================================================================================================
@@ -79,12 +79,16 @@ public:
     }
 
 
-    SharedResourceHandler(const SharedResourceHandler& other) {
+    SharedResourceHandler(const SharedResourceHandler& other)
+        : m_resource(nullptr)
+    {
         Copy(other);
     }
 
 
-    SharedResourceHandler(SharedResourceHandler&& other) {
+    SharedResourceHandler(SharedResourceHandler&& other)
+        : m_resource(nullptr)
+    {
         Move(other);
     }
 
@@ -0,0 +1,181 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// =================================================================================================
+// Vectorized bulk operations on arrays of floats, 32 bit integers and bytes. Every kernel exists in
+// an AVX2, a SSE2 and a scalar version; the best version the processor supports is picked when the
+// first kernel is used. Kernels without a SSE2 form (32 bit integer multiplication) use the scalar
+// version on processors without AVX2.
+// Float sums are added up in a different order than by a plain loop, so they may differ in the
+// last bits. Min and Max of float data containing NaNs are undefined.
+// Fill, Min, Max and Sum work on count elements; Min and Max need at least one.
+
+class SimdKernels {
+public:
+	enum class InstructionSet : uint8_t {
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	static InstructionSet GetInstructionSet(void);
+
+	// use a lower instruction set than the processor supports, e.g. to compare kernels; requests
+	// for a higher one are ignored
+	static void SetInstructionSet(InstructionSet instructionSet);
+
+	static const char* InstructionSetName(void);
+
+	static void Fill(float* data, int32_t count, float value);
+	static void Fill(int32_t* data, int32_t count, int32_t value);
+	static void Fill(uint32_t* data, int32_t count, uint32_t value);
+	static void Fill(uint8_t* data, int32_t count, uint8_t value);
+
+	// index of the first element equal to value, -1 if there is none
+	static int32_t Find(const float* data, int32_t count, float value);
+	static int32_t Find(const int32_t* data, int32_t count, int32_t value);
+	static int32_t Find(const uint8_t* data, int32_t count, uint8_t value);
+
+	static int32_t Count(const float* data, int32_t count, float value);
+	static int32_t Count(const int32_t* data, int32_t count, int32_t value);
+	static int32_t Count(const uint8_t* data, int32_t count, uint8_t value);
+
+	static float Min(const float* data, int32_t count);
+	static int32_t Min(const int32_t* data, int32_t count);
+	static uint8_t Min(const uint8_t* data, int32_t count);
+
+	static float Max(const float* data, int32_t count);
+	static int32_t Max(const int32_t* data, int32_t count);
+	static uint8_t Max(const uint8_t* data, int32_t count);
+
+	static float Sum(const float* data, int32_t count);
+	static int64_t Sum(const int32_t* data, int32_t count);
+	static uint64_t Sum(const uint8_t* data, int32_t count);
+
+	// dest[i] += source[i]
+	static void Add(float* dest, const float* source, int32_t count);
+	static void Add(int32_t* dest, const int32_t* source, int32_t count);
+
+	// dest[i] *= source[i]
+	static void Mul(float* dest, const float* source, int32_t count);
+	static void Mul(int32_t* dest, const int32_t* source, int32_t count);
+
+	// bytewise equality of two memory blocks
+	static bool Equal(const void* a, const void* b, size_t size);
+};
+
+// =================================================================================================
+// Front ends for containers: they take any element type and use a kernel where there is one for it,
+// a plain loop otherwise.
+
+template <typename T>
+inline constexpr bool hasSimdKernels = std::is_same_v<T, float> or std::is_same_v<T, int32_t> or std::is_same_v<T, uint8_t>;
+
+// integer sums are widened to 64 bits
+template <typename T>
+using ArraySumType = std::conditional_t<std::is_integral_v<T>, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>, T>;
+
+
+template <typename T>
+inline void ArrayFill(T* data, int32_t count, const T& value) {
+	if constexpr (hasSimdKernels<T> or std::is_same_v<T, uint32_t>)
+		SimdKernels::Fill(data, count, value);
+	else
+		std::fill(data, data + count, value);
+}
+
+
+template <typename T>
+inline int32_t ArrayFind(const T* data, int32_t count, const T& value) {
+	if constexpr (hasSimdKernels<T>)
+		return SimdKernels::Find(data, count, value);
+	else {
+		for (int32_t i = 0; i < count; i++)
+			if (data[i] == value)
+				return i;
+		return -1;
+	}
+}
+
+
+template <typename T>
+inline int32_t ArrayCount(const T* data, int32_t count, const T& value) {
+	if constexpr (hasSimdKernels<T>)
+		return SimdKernels::Count(data, count, value);
+	else
+		return int32_t(std::count(data, data + count, value));
+}
+
+
+template <typename T>
+inline T ArrayMin(const T* data, int32_t count) {
+	if constexpr (hasSimdKernels<T>)
+		return SimdKernels::Min(data, count);
+	else
+		return *std::min_element(data, data + count);
+}
+
+
+template <typename T>
+inline T ArrayMax(const T* data, int32_t count) {
+	if constexpr (hasSimdKernels<T>)
+		return SimdKernels::Max(data, count);
+	else
+		return *std::max_element(data, data + count);
+}
+
+
+template <typename T>
+inline ArraySumType<T> ArraySum(const T* data, int32_t count) {
+	if constexpr (hasSimdKernels<T>)
+		return SimdKernels::Sum(data, count);
+	else {
+		ArraySumType<T> sum = ArraySumType<T>();
+		for (int32_t i = 0; i < count; i++)
+			sum += data[i];
+		return sum;
+	}
+}
+
+
+template <typename T>
+inline void ArrayAdd(T* dest, const T* source, int32_t count) {
+	if constexpr (std::is_same_v<T, float> or std::is_same_v<T, int32_t>)
+		SimdKernels::Add(dest, source, count);
+	else {
+		for (int32_t i = 0; i < count; i++)
+			dest[i] += source[i];
+	}
+}
+
+
+template <typename T>
+inline void ArrayMul(T* dest, const T* source, int32_t count) {
+	if constexpr (std::is_same_v<T, float> or std::is_same_v<T, int32_t>)
+		SimdKernels::Mul(dest, source, count);
+	else {
+		for (int32_t i = 0; i < count; i++)
+			dest[i] *= source[i];
+	}
+}
+
+
+// types whose values are equal exactly if their bytes are (integers, but not floats) are compared bytewise
+template <typename T>
+inline bool ArrayEqual(const T* a, const T* b, int32_t count) {
+	if constexpr (std::has_unique_object_representations_v<T>)
+		return SimdKernels::Equal(a, b, size_t(count) * sizeof(T));
+	else
+		return std::equal(a, a + count, b);
+}
+
+// =================================================================================================
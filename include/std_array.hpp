@@ -197,6 +197,10 @@ public:
         m_array.reserve(static_cast<size_t>(capacity));
     }
 
+    inline void ShrinkToFit(void) {
+        m_array.shrink_to_fit();
+    }
+
     inline bool AllowResize(size_t newSize) {
         return m_isShrinkable or (newSize > Length());
     }
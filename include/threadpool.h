@@ -0,0 +1,71 @@
+// Copyright (c) 2025 Dietfrid Mali
+// This software is licensed under the MIT License.
+// See the LICENSE file for more details.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+#include "singletonbase.hpp"
+
+// =================================================================================================
+// Fixed set of worker threads running data parallel loops. ParallelFor hands out the indices of a
+// loop one by one to the workers and the calling thread, and returns when all of them are done.
+// One loop runs at a time: a ParallelFor issued from within a task (by any thread running it) or
+// while another thread's loop keeps the pool busy runs on the calling thread alone instead of
+// waiting for the pool.
+// ThreadPool::Instance() is a pool with one worker less than the processor has hardware threads,
+// the calling thread making up for the missing one.
+
+class ThreadPool : public BaseSingleton<ThreadPool> {
+	friend class BaseSingleton<ThreadPool>;
+
+public:
+	using Task = std::function<void(int32_t)>;
+
+private:
+	std::unique_ptr<std::thread[]>	m_workers;
+	int32_t							m_workerCount = 0;
+
+	std::mutex						m_loopLock;		// held by the thread running a loop on the pool
+	std::mutex						m_lock;
+	std::condition_variable			m_wake;
+	std::condition_variable			m_done;
+	const Task*						m_task = nullptr;
+	int32_t							m_count = 0;
+	std::atomic<int32_t>			m_next = 0;		// next index to hand out
+	int32_t							m_finished = 0;	// indices done
+	int32_t							m_busyWorkers = 0;
+	uint64_t						m_generation = 0;	// number of loops started; wakes the workers
+	bool							m_stop = false;
+
+	static thread_local bool		m_isRunningTasks;	// the thread is running tasks of a loop
+
+public:
+	// workerCount < 0: one worker less than the hardware threads
+	explicit ThreadPool(int32_t workerCount = -1);
+
+	~ThreadPool();
+
+	// run task(i) for all i in [0, count)
+	void ParallelFor(int32_t count, const Task& task);
+
+	// threads taking part in a loop, including the calling thread
+	inline int32_t ThreadCount(void) const {
+		return m_workerCount + 1;
+	}
+
+private:
+	void Work(void);
+
+	// run indices of the current loop until there are none left; returns how many were run
+	int32_t RunTasks(void);
+};
+
+// =================================================================================================
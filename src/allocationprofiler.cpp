@@ -0,0 +1,198 @@
+#define NOMINMAX
+
+#include "allocationprofiler.h"
+
+#include <signal.h>
+#include <string.h>
+#include <new>
+
+thread_local int32_t AllocationProfiler::m_countdown = 0;
+
+std::atomic<bool> AllocationProfiler::m_reportRequested = false;
+
+// =================================================================================================
+
+bool AllocationProfiler::Create(int32_t sampleInterval, int32_t ringSize, int32_t siteCapacity, int32_t liveCapacity) {
+	Destroy();
+	uint32_t slotCount = 2;
+	while (slotCount < uint32_t(ringSize))
+		slotCount <<= 1;
+	m_slots = new (std::nothrow) Slot[slotCount];
+	if (not m_slots or not m_sites.Create(siteCapacity, false) or not m_liveSamples.Create(liveCapacity, false)) {
+		Destroy();
+		return false;
+	}
+	for (uint32_t i = 0; i < slotCount; i++)
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+	m_slotMask = slotCount - 1;
+	m_tail.store(0, std::memory_order_relaxed);
+	m_head = 0;
+	m_droppedSamples = 0;
+	m_untrackedSamples = 0;
+	m_sampleInterval.store(sampleInterval, std::memory_order_release);
+	return true;
+}
+
+
+void AllocationProfiler::Destroy(void) {
+	m_sampleInterval.store(0, std::memory_order_release);
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_slots) {
+		delete[] m_slots;
+		m_slots = nullptr;
+	}
+	m_slotMask = 0;
+	m_sites.Destroy();
+	m_liveSamples.Destroy();
+}
+
+
+bool AllocationProfiler::Push(const AllocationSample& sample) {
+	uint32_t pos = m_tail.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = m_slots + (pos & m_slotMask);
+		int32_t distance = int32_t(slot->sequence.load(std::memory_order_acquire) - pos);
+		if (distance == 0) {
+			if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (distance < 0) // the ring is full
+			return false;
+		else
+			pos = m_tail.load(std::memory_order_relaxed);
+	}
+	slot->sample = sample;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+
+// move all samples from the ring buffer to the call site statistics. m_lock must be held
+void AllocationProfiler::Drain(void) {
+	for (;;) {
+		Slot* slot = m_slots + (m_head & m_slotMask);
+		if (int32_t(slot->sequence.load(std::memory_order_acquire) - (m_head + 1)) < 0)
+			break;
+		AllocationSample sample = slot->sample;
+		slot->sequence.store(m_head + m_slotMask + 1, std::memory_order_release);
+		++m_head;
+
+		if (sample.caller) {
+			AllocationSite* site = m_sites.Claim(SiteHash(reinterpret_cast<void*>(sample.caller)));
+			if (not site) // site table is full
+				continue;
+			if (not site->sampleCount)
+				site->caller = sample.caller;
+			++site->sampleCount;
+			site->sampledBytes += sample.size;
+			AllocationSample* live = m_liveSamples.Claim(sample.address);
+			if (not live) {
+				++m_untrackedSamples;
+				continue;
+			}
+			*live = sample;
+			++site->liveCount;
+			site->liveBytes += sample.size;
+		}
+		else {
+			AllocationSample* live = m_liveSamples.FindItem(sample.address);
+			if (not live)
+				continue;
+			AllocationSite* site = m_sites.FindItem(SiteHash(reinterpret_cast<void*>(live->caller)));
+			if (site) {
+				--site->liveCount;
+				site->liveBytes -= live->size;
+			}
+			m_liveSamples.Release(sample.address);
+		}
+	}
+}
+
+
+// drain the ring buffer unless another thread is already doing it
+void AllocationProfiler::TryDrain(void) {
+	if (m_lock.try_lock()) {
+		Drain();
+		m_lock.unlock();
+	}
+}
+
+
+void AllocationProfiler::RecordAlloc(void* address, uint32_t size, void* caller) {
+	if (not IsActive())
+		return;
+	AllocationSample sample = { uintptr_t(address), uintptr_t(caller), size };
+	if (not Push(sample)) {
+		TryDrain();
+		if (not Push(sample))
+			++m_droppedSamples;
+	}
+	if (m_reportRequested.load(std::memory_order_relaxed) and m_reportRequested.exchange(false))
+		Report(m_reportPath);
+}
+
+
+void AllocationProfiler::RecordFree(void* address) {
+	if (not IsActive()) // blocks sampled before the profiler was stopped
+		return;
+	AllocationSample sample = { uintptr_t(address), 0, 0 };
+	if (not Push(sample)) {
+		TryDrain();
+		if (not Push(sample))
+			++m_droppedSamples;
+	}
+}
+
+
+bool AllocationProfiler::Report(FILE* stream) {
+	if (not stream)
+		return false;
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (not m_slots)
+		return false;
+	Drain();
+	int64_t interval = SampleInterval();
+	fprintf(stream, "site,caller,samples,sampled_bytes,live_samples,live_bytes,estimated_live_bytes\n");
+	m_sites.WalkItems([&](const uint32_t& key, AllocationSite& site) {
+		fprintf(stream, "%08x,0x%llx,%llu,%llu,%lld,%lld,%lld\n", key, (unsigned long long) site.caller,
+				(unsigned long long) site.sampleCount, (unsigned long long) site.sampledBytes,
+				(long long) site.liveCount, (long long) site.liveBytes, (long long) (site.liveBytes * interval));
+		return true;
+	});
+	fprintf(stream, "# sample interval %lld, %llu samples dropped, %llu samples not tracked\n", (long long) interval,
+			(unsigned long long) m_droppedSamples.load(), (unsigned long long) m_untrackedSamples);
+	return true;
+}
+
+
+bool AllocationProfiler::Report(const char* path) {
+	if (not (path and *path))
+		return false;
+	FILE* stream = fopen(path, "w");
+	if (not stream) {
+		fprintf(stderr, "%s (%d): cannot open '%s'\n", __FILE__, __LINE__, path);
+		return false;
+	}
+	bool result = Report(stream);
+	fclose(stream);
+	return result;
+}
+
+
+bool AllocationProfiler::InstallSignalHandler(const char* reportPath) {
+	strncpy(m_reportPath, reportPath, sizeof(m_reportPath) - 1);
+	m_reportPath[sizeof(m_reportPath) - 1] = '\0';
+#ifdef SIGUSR2
+	return signal(SIGUSR2, SignalHandler) != SIG_ERR;
+#else
+	return false;
+#endif
+}
+
+
+void AllocationProfiler::SignalHandler(int) {
+	m_reportRequested.store(true);
+}
+
+// =================================================================================================
@@ -4,7 +4,7 @@
 #include <new>
 #include "allocator.h"
 
-static bool initializing = false;
+static thread_local bool initializing = false; // per thread recursion guard
 
 static MemoryDescriptor* itemPool = nullptr;
 
@@ -24,7 +24,7 @@ inline void InitAllocator(int capacity = 1000000) {
 
 void* Allocator::operator new(std::size_t size) {
 	::InitAllocator();
-	return MemoryManager::Instance().Alloc(size);
+	return MemoryManager::Instance().Alloc(size, CALLER_ADDRESS());
 }
 
 void Allocator::operator delete(void* ptr) noexcept {
@@ -33,7 +33,7 @@ void Allocator::operator delete(void* ptr) noexcept {
 
 void* Allocator::operator new[](std::size_t size) {
 	::InitAllocator();
-	return MemoryManager::Instance().Alloc(size);
+	return MemoryManager::Instance().Alloc(size, CALLER_ADDRESS());
 }
 
 void Allocator::operator delete[](void* ptr) noexcept {
@@ -48,7 +48,7 @@ void Allocator::operator delete[](void* ptr) noexcept {
 
 void* operator new(std::size_t size) {
 	InitAllocator();
-	return MemoryManager::Instance().Alloc(size);
+	return MemoryManager::Instance().Alloc(size, CALLER_ADDRESS());
 }
 
 void operator delete(void* ptr) noexcept {
@@ -57,7 +57,7 @@ void operator delete(void* ptr) noexcept {
 
 void* operator new[](std::size_t size) {
 	InitAllocator();
-	return MemoryManager::Instance().Alloc(size);
+	return MemoryManager::Instance().Alloc(size, CALLER_ADDRESS());
 }
 
 void operator delete[](void* ptr) noexcept {
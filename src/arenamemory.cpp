@@ -0,0 +1,255 @@
+#define NOMINMAX
+
+#include "arenamemory.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+#define HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+
+// mbind memory policy, see numaif.h; defined here to avoid depending on libnuma
+#define MPOL_PREFERRED_POLICY	1
+
+// =================================================================================================
+
+static inline size_t RoundUp(size_t size, size_t granularity) {
+	return (size + granularity - 1) / granularity * granularity;
+}
+
+
+static inline size_t RoundDown(size_t size, size_t granularity) {
+	return size / granularity * granularity;
+}
+
+
+bool ArenaMemory::Create(const ArenaOptions& options) {
+	Destroy();
+	int numaNode = (options.numaNode == NUMA_LOCAL_NODE) ? CurrentNumaNode() : options.numaNode;
+	if (Map(options.arenaSize, options.useHugePages, numaNode)) {
+		if (numaNode == NUMA_THREAD_NODES)
+			m_numaNode = NUMA_THREAD_NODES;
+		m_commitSize = RoundUp(std::max(options.commitSize, m_pageSize), m_pageSize);
+		return true;
+	}
+	m_address = reinterpret_cast<Address>(malloc(options.arenaSize));
+	if (not m_address)
+		return false;
+	m_size = options.arenaSize;
+	m_committed = m_size;
+	m_commitSize = m_size;
+	m_pageSize = 0;
+	m_numaNode = NUMA_NO_NODE;
+	m_backing = Backing::Heap;
+	return true;
+}
+
+
+#ifdef _WIN32
+
+bool ArenaMemory::Map(size_t size, bool useHugePages, int numaNode) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	size_t largePageSize = useHugePages ? GetLargePageMinimum() : 0;
+	// large pages must be committed right away; they fail without the lock pages in memory privilege.
+	// Regular pages are only reserved here and committed by CommitRange.
+	for (int attempt = largePageSize ? 0 : 1; attempt < 2; attempt++) {
+		size_t pageSize = attempt ? size_t(info.dwPageSize) : largePageSize;
+		size_t mapSize = RoundUp(size, pageSize);
+		DWORD flags = attempt ? MEM_RESERVE : MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES;
+		void* p = (numaNode >= 0)
+				  ? VirtualAllocExNuma(GetCurrentProcess(), nullptr, mapSize, flags, PAGE_READWRITE, DWORD(numaNode))
+				  : VirtualAlloc(nullptr, mapSize, flags, PAGE_READWRITE);
+		if (p) {
+			m_address = reinterpret_cast<Address>(p);
+			m_size = mapSize;
+			m_committed = attempt ? 0 : mapSize;
+			m_pageSize = pageSize;
+			m_numaNode = numaNode;
+			m_backing = attempt ? Backing::Pages : Backing::HugePages;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool ArenaMemory::CommitRange(Address end) {
+	size_t committed = std::min(RoundUp(size_t(end - m_address), m_commitSize), m_size);
+	if (m_address + committed < end)
+		return false;
+	void* p = (m_numaNode >= 0)
+			  ? VirtualAllocExNuma(GetCurrentProcess(), m_address + m_committed, committed - m_committed, MEM_COMMIT, PAGE_READWRITE, DWORD(m_numaNode))
+			  : VirtualAlloc(m_address + m_committed, committed - m_committed, MEM_COMMIT, PAGE_READWRITE);
+	if (not p)
+		return false;
+	m_committed = committed;
+	return true;
+}
+
+
+// the pages stay committed, so the memory can be used again without recommitting it
+void ArenaMemory::DiscardRange(Address start, size_t size) {
+	VirtualAlloc(start, size, MEM_RESET, PAGE_READWRITE);
+}
+
+
+void ArenaMemory::Destroy(void) {
+	if (m_address) {
+		if (m_backing == Backing::Heap)
+			free(m_address);
+		else
+			VirtualFree(m_address, 0, MEM_RELEASE);
+	}
+	m_address = nullptr;
+	m_size = 0;
+	m_committed = 0;
+	m_backing = Backing::None;
+}
+
+
+int ArenaMemory::CurrentNumaNode(void) {
+	PROCESSOR_NUMBER processor;
+	USHORT node;
+	GetCurrentProcessorNumberEx(&processor);
+	return GetNumaProcessorNodeEx(&processor, &node) ? int(node) : 0;
+}
+
+
+bool ArenaMemory::BindToNode(Address address, size_t size, int node) {
+	return false; // Windows places pages when they are allocated (VirtualAllocExNuma)
+}
+
+#else
+
+bool ArenaMemory::Map(size_t size, bool useHugePages, int numaNode) {
+	size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+	void* p = MAP_FAILED;
+	size_t mapSize = RoundUp(size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+	// explicit huge pages only succeed if the administrator has reserved enough of them.
+	// They must not be mapped with MAP_NORESERVE, or touching them would fault with SIGBUS
+	// instead of mmap failing when there are not enough of them.
+	if (useHugePages) {
+		p = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p != MAP_FAILED) {
+			m_committed = mapSize;
+			m_pageSize = HUGE_PAGE_SIZE;
+			m_backing = Backing::HugePages;
+		}
+	}
+#endif
+	if (p == MAP_FAILED) {
+		// only reserve address space; CommitRange makes it accessible
+		p = mmap(nullptr, mapSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (p == MAP_FAILED)
+			return false;
+		m_committed = 0;
+		m_pageSize = pageSize;
+		m_backing = Backing::Pages;
+#ifdef MADV_HUGEPAGE
+		if (useHugePages and not madvise(p, mapSize, MADV_HUGEPAGE))
+			m_backing = Backing::TransparentHugePages;
+#endif
+	}
+	m_address = reinterpret_cast<Address>(p);
+	m_size = mapSize;
+	// pages are placed when first touched, so binding the untouched mapping places all of them
+	m_numaNode = ((numaNode >= 0) and BindToNode(m_address, m_size, numaNode)) ? numaNode : NUMA_NO_NODE;
+	return true;
+}
+
+
+void ArenaMemory::Destroy(void) {
+	if (m_address) {
+		if (m_backing == Backing::Heap)
+			free(m_address);
+		else
+			munmap(m_address, m_size);
+	}
+	m_address = nullptr;
+	m_size = 0;
+	m_committed = 0;
+	m_backing = Backing::None;
+}
+
+
+bool ArenaMemory::CommitRange(Address end) {
+	size_t committed = std::min(RoundUp(size_t(end - m_address), m_commitSize), m_size);
+	if (m_address + committed < end)
+		return false;
+	if (mprotect(m_address + m_committed, committed - m_committed, PROT_READ | PROT_WRITE))
+		return false;
+	m_committed = committed;
+	return true;
+}
+
+
+// the pages stay accessible and are faulted in again, zero filled, when they are touched
+void ArenaMemory::DiscardRange(Address start, size_t size) {
+	madvise(start, size, MADV_DONTNEED);
+}
+
+
+int ArenaMemory::CurrentNumaNode(void) {
+#ifdef SYS_getcpu
+	unsigned cpu, node;
+	if (not syscall(SYS_getcpu, &cpu, &node, nullptr))
+		return int(node);
+#endif
+	return 0;
+}
+
+
+bool ArenaMemory::BindToNode(Address address, size_t size, int node) {
+#ifdef SYS_mbind
+	if ((node < 0) or (node >= 64))
+		return false;
+	uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+	uintptr_t start = (uintptr_t(address) + pageSize - 1) & ~(pageSize - 1);
+	uintptr_t end = (uintptr_t(address) + size) & ~(pageSize - 1);
+	if (start >= end)
+		return false;
+	unsigned long nodeMask = 1ul << node;
+	return not syscall(SYS_mbind, start, end - start, MPOL_PREFERRED_POLICY, &nodeMask, sizeof(nodeMask) * 8, 0);
+#else
+	return false;
+#endif
+}
+
+#endif
+
+
+void ArenaMemory::Decommit(Address start, Address end) {
+	if ((m_backing == Backing::None) or (m_backing == Backing::Heap))
+		return;
+	size_t first = RoundUp(size_t(start - m_address), m_commitSize);
+	size_t last = RoundDown(std::min(size_t(end - m_address), m_committed), m_commitSize);
+	if (first < last)
+		DiscardRange(m_address + first, last - first);
+}
+
+
+const char* ArenaMemory::BackingName(void) const {
+	switch (m_backing) {
+		case Backing::Heap:
+			return "heap";
+		case Backing::Pages:
+			return "pages";
+		case Backing::TransparentHugePages:
+			return "transparent huge pages";
+		case Backing::HugePages:
+			return "huge pages";
+		default:
+			return "none";
+	}
+}
+
+// =================================================================================================
@@ -0,0 +1,2025 @@
+#define NOMINMAX
+
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#ifdef __cpp_lib_parallel_algorithm
+#include <execution>
+#endif
+#ifdef __linux__
+#	include <unistd.h>
+#endif
+
+#include "fastdatapool.hpp"
+#include "custom_list.hpp"
+#include "segmentedlist.hpp"
+#include "custom_array.hpp"
+#include "custom_stack.hpp"
+#include "threadpool.h"
+#include "concurrentqueue.hpp"
+#include "simdkernels.h"
+#include "avltree.hpp"
+#include "memorymanager.h"
+#include "arenamemory.h"
+#include "monotonicarena.hpp"
+#include "parallelsort.hpp"
+
+// =================================================================================================
+// Self checks for the containers and allocators. Every test prints a line per failed check and
+// main returns the number of failures. With "bench" on the command line, the timings the
+// containers were tuned with are printed as well.
+
+static int failures = 0;
+
+#define CHECK(_condition) \
+	do { \
+		if (not (_condition)) { \
+			fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #_condition); \
+			++failures; \
+		} \
+	} while (0)
+
+
+class BenchTimer {
+	std::chrono::steady_clock::time_point	m_start;
+
+public:
+	BenchTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+	// seconds since construction
+	double Elapsed(void) const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+	}
+};
+
+// =================================================================================================
+// BasicDataPool
+
+// Item that counts its live instances and owns a heap buffer, so constructing a slot twice or
+// never destructing it shows up in the count (and as a leak under a leak checker).
+struct CountedItem {
+	static int32_t		liveCount;
+	std::string			text;
+	int32_t				value = 0;
+
+	CountedItem() : text(32, 'x') { ++liveCount; }
+	CountedItem(const CountedItem& other) : text(other.text), value(other.value) { ++liveCount; }
+	CountedItem& operator= (const CountedItem& other) = default;
+	~CountedItem() { --liveCount; }
+};
+
+int32_t CountedItem::liveCount = 0;
+
+
+// gives the test access to the slot generations, to reach the wrap around without 2^32 releases
+class GenerationPool : public BasicDataPool<int32_t> {
+public:
+	void SetGeneration(int itemIndex, uint32_t generation) {
+		m_generations[itemIndex] = generation;
+	}
+};
+
+
+static void TestHandles(void) {
+	GenerationPool pool;
+	CHECK(pool.Create(4));
+	Handle<int32_t> null;
+	CHECK(null.IsNull() and not pool.IsValid(null) and (pool.Resolve(null) == nullptr));
+	CHECK(pool.Resolve(Handle<int32_t>(7, 1)) == nullptr);		// index out of range
+
+	Handle<int32_t> first;
+	int32_t* item = pool.Claim(first);
+	CHECK(item and not first.IsNull());
+	CHECK(pool.Resolve(first) == item);
+	CHECK(pool.GetHandle(item) == first);
+	*item = 42;
+	CHECK(pool.Release(first) == item);
+	// the stale handle neither resolves nor releases the slot again, also after it was reclaimed
+	CHECK(pool.Resolve(first) == nullptr);
+	CHECK(pool.Release(first) == nullptr);
+	CHECK(pool.FreeItemCount() == 4);
+	Handle<int32_t> second;
+	CHECK(pool.Claim(second) == item);
+	CHECK((second.Index() == first.Index()) and (second != first));
+	CHECK(pool.Resolve(first) == nullptr);
+	CHECK(pool.Resolve(second) == item);
+
+	// releasing at the last generation skips generation zero, which marks null handles
+	pool.Release(second);
+	pool.SetGeneration(int(second.Index()), 0xFFFFFFFFu);
+	Handle<int32_t> last;
+	CHECK(pool.Claim(last) == item);
+	CHECK(last.Generation() == 0xFFFFFFFFu);
+	pool.Release(last);
+	Handle<int32_t> wrapped;
+	CHECK(pool.Claim(wrapped) == item);
+	CHECK(wrapped.Generation() == 1);
+	CHECK(not wrapped.IsNull() and (pool.Resolve(wrapped) == item));
+	CHECK(pool.Resolve(last) == nullptr);
+}
+
+
+static void TestBasicDataPool(void) {
+	{
+		BasicDataPool<CountedItem> pool;
+		CHECK(pool.Create(8));
+		CHECK(CountedItem::liveCount == 8);
+		int itemIndex;
+		CountedItem* item = pool.Claim(itemIndex);
+		CHECK(item and (CountedItem::liveCount == 8));
+		item->value = 5;
+		item->text = "used";
+		pool.Release(itemIndex);
+		// a reclaimed slot comes back reset, without another instance
+		CountedItem* reclaimed = pool.Claim(itemIndex);
+		CHECK(reclaimed == item);
+		CHECK((reclaimed->value == 0) and (reclaimed->text.size() == 32));
+		CHECK(CountedItem::liveCount == 8);
+		for (int32_t i = 0; i < 7; i++)
+			CHECK(pool.Claim(itemIndex) != nullptr);
+		CHECK(pool.Claim(itemIndex) == nullptr);
+		CHECK(CountedItem::liveCount == 8);
+		CHECK(pool.Create(4, false));
+		CHECK(CountedItem::liveCount == 4);
+	}
+	CHECK(CountedItem::liveCount == 0);
+}
+
+// =================================================================================================
+// FastDataPool
+
+// Hash that maps keys to chosen hash values, to set up probe chains. FastDataPool multiplies the
+// hash by 0x9E3779B97F4A7C15 and takes bits 32 and up as the home slot; HashForSlot finds a hash
+// value for a given home slot.
+struct ChainHash {
+	size_t operator()(int32_t key) const {
+		return size_t(key >> 8);
+	}
+};
+
+
+static int32_t HashForSlot(uint32_t slot, uint32_t slotMask) {
+	for (int32_t h = 0;; h++) {
+		if ((uint32_t((uint64_t(h) * 0x9E3779B97F4A7C15ull) >> 32) & slotMask) == slot)
+			return h;
+	}
+}
+
+
+static void TestFastDataPool(bool bench) {
+	// capacity 8 gives a table of 16 slots. Six keys share the last slot as their home slot, so
+	// their chain wraps around to slots 0 through 4; two keys homed at slot 1 are displaced behind
+	// them. Releasing chain members has to shift the wrapped entries back across the table end.
+	FastDataPool<int32_t, int32_t, ChainHash> pool;
+	CHECK(pool.Create(8));
+	int32_t lastHash = HashForSlot(15, 15);
+	int32_t slot1Hash = HashForSlot(1, 15);
+	int32_t keys[8];
+	for (int32_t i = 0; i < 6; i++)
+		keys[i] = (lastHash << 8) | i;
+	keys[6] = (slot1Hash << 8) | 6;
+	keys[7] = (slot1Hash << 8) | 7;
+	for (int32_t i = 0; i < 8; i++) {
+		int32_t* item = pool.Claim(keys[i]);
+		CHECK(item != nullptr);
+		if (item)
+			*item = i;
+	}
+	CHECK(pool.ItemCount() == 8);
+	CHECK(pool.Claim(keys[3]) == pool.FindItem(keys[3]));	// claiming a used key returns its item
+	CHECK(pool.Claim(12345) == nullptr);					// pool is full
+	for (int32_t i = 0; i < 8; i++)
+		CHECK(pool.FindItem(keys[i]) and (*pool.FindItem(keys[i]) == i));
+
+	// release from the front, the middle and the end of the chain, checking all others each time
+	bool isReleased[8] = {};
+	for (int32_t i : { 0, 3, 7, 5, 1 }) {
+		CHECK(pool.Release(keys[i]) != nullptr);
+		CHECK(pool.Release(keys[i]) == nullptr);
+		isReleased[i] = true;
+		for (int32_t j = 0; j < 8; j++) {
+			int32_t* item = pool.FindItem(keys[j]);
+			CHECK(isReleased[j] ? (item == nullptr) : (item and (*item == j)));
+		}
+	}
+	CHECK(pool.ItemCount() == 3);
+	int32_t walked = 0;
+	pool.WalkItems([&](const int32_t& key, int32_t& item) { ++walked; return key == keys[item]; });
+	CHECK(walked == 3);
+
+	// re-creating the pool replaces all tables
+	CHECK(pool.Create(64, false));
+	CHECK(pool.ItemCount() == 0);
+	CHECK(pool.FindItem(keys[2]) == nullptr);
+
+	// random claims and releases against a plain presence table
+	FastDataPool<int32_t, int32_t> randomPool;
+	CHECK(randomPool.Create(1000));
+	bool isUsed[4096] = {};
+	int32_t usedCount = 0;
+	std::mt19937 random(27);
+	for (int32_t i = 0; i < 200000; i++) {
+		int32_t key = int32_t(random() % 4096);
+		if (isUsed[key]) {
+			CHECK(randomPool.Release(key) != nullptr);
+			isUsed[key] = false;
+			--usedCount;
+		}
+		else if (usedCount < 1000) {
+			CHECK(randomPool.Claim(key) != nullptr);
+			isUsed[key] = true;
+			++usedCount;
+		}
+		key = int32_t(random() % 4096);
+		CHECK((randomPool.FindItem(key) != nullptr) == isUsed[key]);
+	}
+	CHECK(randomPool.ItemCount() == usedCount);
+
+	if (bench) {
+		const int32_t capacity = 100000;
+		FastDataPool<int32_t, int32_t> fastPool;
+		fastPool.Create(capacity);
+		// DataPool's layout: a BasicDataPool whose item indices are kept in an AVL tree
+		BasicDataPool<int32_t> treePool;
+		AVLTree<int32_t, int> treeIndex;
+		treePool.Create(capacity);
+		treeIndex.SetComparator([](void*, const int32_t& a, const int32_t& b) { return (a < b) ? -1 : (a > b) ? 1 : 0; });
+		int32_t* keyList = new int32_t[capacity];
+		for (int32_t i = 0; i < capacity; i++)
+			keyList[i] = int32_t(random());
+		BenchTimer fastTimer;
+		for (int32_t i = 0; i < capacity; i++)
+			fastPool.Claim(keyList[i]);
+		for (int32_t i = 0; i < capacity; i++)
+			fastPool.FindItem(keyList[i]);
+		for (int32_t i = 0; i < capacity; i++)
+			fastPool.Release(keyList[i]);
+		double fastTime = fastTimer.Elapsed();
+		BenchTimer treeTimer;
+		for (int32_t i = 0; i < capacity; i++) {
+			int itemIndex;
+			if (treePool.Claim(itemIndex))
+				treeIndex.Insert(keyList[i], itemIndex);
+		}
+		for (int32_t i = 0; i < capacity; i++)
+			treeIndex.Find(keyList[i]);
+		for (int32_t i = 0; i < capacity; i++) {
+			int itemIndex;
+			if (treeIndex.Extract(keyList[i], itemIndex))
+				treePool.Release(itemIndex);
+		}
+		double treeTime = treeTimer.Elapsed();
+		delete[] keyList;
+		printf("claim, find and release %d keys: FastDataPool %.2f ms, AVL indexed pool %.2f ms\n", capacity, fastTime * 1000, treeTime * 1000);
+	}
+}
+
+// =================================================================================================
+// SPSCQueue and MPSCQueue
+
+// Producers append producerCount * itemCount values tagged with their producer, which the
+// consumer extracts; items of each producer have to arrive in order. Returns the seconds taken.
+template <typename QUEUE_T>
+static double PassItems(QUEUE_T& queue, int32_t producerCount, int32_t itemCount) {
+	BenchTimer timer;
+	std::vector<std::thread> producers;
+	for (int32_t p = 0; p < producerCount; p++) {
+		producers.emplace_back([&queue, p, itemCount]() {
+			for (int32_t i = 0; i < itemCount; i++) {
+				while (not queue.Append(int64_t(p) << 32 | i))
+					std::this_thread::yield();
+			}
+			});
+	}
+	std::vector<int32_t> next(producerCount, 0);
+	bool isOrdered = true;
+	for (int64_t received = 0; received < int64_t(producerCount) * itemCount; ) {
+		int64_t value;
+		if (not queue.Extract(value, 0)) {
+			std::this_thread::yield();
+			continue;
+		}
+		int32_t p = int32_t(value >> 32);
+		isOrdered = isOrdered and (p < producerCount) and (int32_t(value & 0xFFFFFFFF) == next[p]++);
+		++received;
+	}
+	for (std::thread& producer : producers)
+		producer.join();
+	CHECK(isOrdered);
+	CHECK(queue.IsEmpty());
+	return timer.Elapsed();
+}
+
+
+// List guarded by a mutex, the way the queues were used before
+class LockedList {
+	List<int64_t>	m_list;
+	std::mutex		m_lock;
+
+public:
+	bool Append(int64_t value) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_list.Append(value) != nullptr;
+	}
+
+	bool Extract(int64_t& value, int i) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		return not m_list.IsEmpty() and m_list.Extract(value, i);
+	}
+
+	bool IsEmpty(void) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_list.IsEmpty();
+	}
+};
+
+
+static void TestQueues(bool bench) {
+	// single threaded: a full ring refuses items, and positions wrap around the ring
+	SPSCQueue<int64_t> ring(5);
+	CHECK(ring.Capacity() == 8);
+	int64_t value;
+	for (int32_t round = 0; round < 3; round++) {
+		for (int32_t i = 0; i < 8; i++)
+			CHECK(ring.Append(int64_t(i)));
+		CHECK(not ring.Append(int64_t(8)));
+		CHECK(ring.Length() == 8);
+		for (int32_t i = 0; i < 5; i++)
+			CHECK(ring.Extract(value) and (value == i));
+		CHECK(not ring.Extract(value, 1));
+		for (int32_t i = 5; i < 8; i++)
+			CHECK(ring.Extract(value) and (value == i));
+		CHECK(not ring.Extract(value));
+	}
+	MPSCQueue<int64_t> list;
+	CHECK(not list.Extract(value));
+	for (int32_t i = 0; i < 100; i++)	// more than a batch of released nodes
+		list.Append(int64_t(i));
+	for (int32_t i = 0; i < 100; i++)
+		CHECK(list.Extract(value) and (value == i));
+	CHECK(list.IsEmpty());
+
+	const int32_t itemCount = bench ? 1000000 : 20000;
+	SPSCQueue<int64_t> spsc(256);
+	double spscTime = PassItems(spsc, 1, itemCount);
+	MPSCQueue<int64_t> mpsc;
+	double mpscTime = PassItems(mpsc, 3, itemCount);
+	if (bench) {
+		LockedList spscList, mpscList;
+		double spscListTime = PassItems(spscList, 1, itemCount);
+		double mpscListTime = PassItems(mpscList, 3, itemCount);
+		printf("pass %d items from 1 producer: SPSCQueue %.2f ms, locked List %.2f ms\n", itemCount, spscTime * 1000, spscListTime * 1000);
+		printf("pass %d items from 3 producers: MPSCQueue %.2f ms, locked List %.2f ms\n", 3 * itemCount, mpscTime * 1000, mpscListTime * 1000);
+	}
+}
+
+// =================================================================================================
+// SimdKernels
+
+// Runs every kernel for element type T on all counts up to a few vectors and at every alignment
+// within a vector, so the vector loops and their scalar heads and tails all run, and compares the
+// results with plain loops. Values are small integers, so float sums are exact in any order.
+template <typename T>
+static bool KernelsMatchLoops(std::mt19937& random) {
+	using SumType = ArraySumType<T>;
+	bool isMatching = true;
+	std::vector<T> buffer(160), other(160), expected(160);
+	for (int32_t offset = 0; offset < 32; offset += 3) {
+		for (int32_t count = 0; count <= 100; count++) {
+			T* data = buffer.data() + offset;
+			for (int32_t i = 0; i < count; i++) {
+				data[i] = T(random() % 16);
+				other[i] = T(random() % 8);
+			}
+			T value = T(random() % 16);
+			int32_t first = -1, matches = 0;
+			T min = count ? data[0] : T(0), max = min;
+			SumType sum = 0;
+			for (int32_t i = 0; i < count; i++) {
+				if (data[i] == value) {
+					if (first < 0)
+						first = i;
+					++matches;
+				}
+				min = std::min(min, data[i]);
+				max = std::max(max, data[i]);
+				sum += data[i];
+			}
+			isMatching = isMatching and (SimdKernels::Find(data, count, value) == first) and (SimdKernels::Count(data, count, value) == matches);
+			if (count)
+				isMatching = isMatching and (SimdKernels::Min(data, count) == min) and (SimdKernels::Max(data, count) == max);
+			isMatching = isMatching and (SimdKernels::Sum(data, count) == sum);
+			isMatching = isMatching and SimdKernels::Equal(data, data, count * sizeof(T));
+			if (count) {
+				memcpy(expected.data(), data, count * sizeof(T));
+				expected[count - 1] = T(expected[count - 1] + 1);	// differs in the last element only
+				isMatching = isMatching and not SimdKernels::Equal(data, expected.data(), count * sizeof(T));
+			}
+			if constexpr (not std::is_same_v<T, uint8_t>) {
+				for (int32_t i = 0; i < count; i++)
+					expected[i] = T(data[i] + other[i]);
+				SimdKernels::Add(data, other.data(), count);
+				isMatching = isMatching and not memcmp(data, expected.data(), count * sizeof(T));
+				for (int32_t i = 0; i < count; i++)
+					expected[i] = T(data[i] * other[i]);
+				SimdKernels::Mul(data, other.data(), count);
+				isMatching = isMatching and not memcmp(data, expected.data(), count * sizeof(T));
+			}
+			// Fill must not write past the last element
+			data[count] = T(1);
+			SimdKernels::Fill(data, count, value);
+			isMatching = isMatching and (data[count] == T(1)) and (std::count(data, data + count, value) == count);
+		}
+	}
+	return isMatching;
+}
+
+
+static void TestSimdKernels(bool bench) {
+	std::mt19937 random(45);
+	SimdKernels::InstructionSet supported = SimdKernels::GetInstructionSet();
+	for (int32_t set = int32_t(supported); set >= 0; set--) {
+		SimdKernels::SetInstructionSet(SimdKernels::InstructionSet(set));
+		CHECK(KernelsMatchLoops<float>(random));
+		CHECK(KernelsMatchLoops<int32_t>(random));
+		CHECK(KernelsMatchLoops<uint8_t>(random));
+	}
+
+	if (bench) {
+		const int32_t count = 1 << 20;
+		const int32_t rounds = 200;
+		std::vector<float> values(count);
+		for (float& v : values)
+			v = float(random() % 1000);
+		for (int32_t set = int32_t(supported); set >= 0; set--) {
+			SimdKernels::SetInstructionSet(SimdKernels::InstructionSet(set));
+			float sum = 0;
+			int32_t found = 0;
+			BenchTimer timer;
+			for (int32_t i = 0; i < rounds; i++) {
+				sum += SimdKernels::Sum(values.data(), count);
+				found += SimdKernels::Count(values.data(), count, float(i));
+			}
+			double time = timer.Elapsed();
+			CHECK((sum > 0) and (found > 0));
+			printf("sum and count %d floats: %s %.3f ms\n", count, SimdKernels::InstructionSetName(), time * 1000 / rounds);
+		}
+	}
+	SimdKernels::SetInstructionSet(supported);
+}
+
+// =================================================================================================
+// ManagedArray
+
+static void TestManagedArray(bool bench) {
+	// appending grows the buffer geometrically, relocating the (non-trivial) elements intact
+	ManagedArray<std::string> strings;
+	int32_t bufferCount = 0;
+	std::string* buffer = nullptr;
+	for (int32_t i = 0; i < 10000; i++) {
+		CHECK(strings.Append(std::to_string(i)) != nullptr);
+		if (strings.Data() != buffer) {
+			buffer = strings.Data();
+			++bufferCount;
+		}
+	}
+	CHECK(bufferCount <= 15);	// 4, 8, ... 16384
+	CHECK((strings.Length() == 10000) and (strings.Capacity() >= 10000));
+	bool isIntact = true;
+	for (int32_t i = 0; i < 10000; i++)
+		isIntact = isIntact and (strings[i] == std::to_string(i));
+	CHECK(isIntact);
+
+	// Reserve keeps the contents and never shrinks; ShrinkToFit trims the capacity to the length
+	CHECK(strings.Reserve(20000) and (strings.Capacity() >= 20000) and (strings[9999] == "9999"));
+	strings.Reserve(100);
+	CHECK(strings.Capacity() >= 20000);
+	strings.Resize(300);
+	strings.ShrinkToFit();
+	CHECK((strings.Capacity() == 300) and (strings[299] == "299"));
+	strings.Resize(0);
+	strings.ShrinkToFit();
+	CHECK(strings.Capacity() == 0);
+
+	if (bench) {
+		const int32_t count = 1000000;
+		BenchTimer arrayTimer;
+		ManagedArray<int32_t> values;
+		for (int32_t i = 0; i < count; i++)
+			values.Append(i);
+		ManagedArray<std::string> texts;
+		for (int32_t i = 0; i < count; i++)
+			texts.Append(std::string(20, 'a'));
+		double arrayTime = arrayTimer.Elapsed();
+		BenchTimer vectorTimer;
+		std::vector<int32_t> vectorValues;
+		for (int32_t i = 0; i < count; i++)
+			vectorValues.push_back(i);
+		std::vector<std::string> vectorTexts;
+		for (int32_t i = 0; i < count; i++)
+			vectorTexts.push_back(std::string(20, 'a'));
+		double vectorTime = vectorTimer.Elapsed();
+		CHECK((values.Length() == count) and (texts.Length() == count));
+		printf("append %d ints and %d strings: ManagedArray %.2f ms, std::vector %.2f ms\n", count, count, arrayTime * 1000, vectorTime * 1000);
+	}
+}
+
+// =================================================================================================
+// Relocation
+
+// Element that points to itself and counts its live instances; relocating it by copying its bytes
+// would leave the copy pointing at the old place.
+struct SelfRef {
+	static int32_t	liveCount;
+	SelfRef*		self;
+	int32_t			value;
+
+	SelfRef(int32_t _value = 0) : self(this), value(_value) { ++liveCount; }
+	SelfRef(const SelfRef& other) : self(this), value(other.value) { ++liveCount; }
+	SelfRef(SelfRef&& other) noexcept : self(this), value(other.value) { other.value = -1; ++liveCount; }
+	~SelfRef() { --liveCount; }
+
+	SelfRef& operator= (const SelfRef& other) {
+		value = other.value;
+		return *this;
+	}
+
+	SelfRef& operator= (SelfRef&& other) noexcept {
+		value = other.value;
+		other.value = -1;
+		return *this;
+	}
+
+	bool operator< (const SelfRef& other) const {
+		return value < other.value;
+	}
+
+	bool IsIntact(void) const {
+		return self == this;
+	}
+};
+
+int32_t SelfRef::liveCount = 0;
+
+
+// Element owning a heap value that opts into relocation by copying its bytes; relocating it must
+// not move construct it, and must not destroy the source (which would free the value twice).
+struct OwnedValue {
+	static int32_t	moveCount;
+	int32_t*		value;
+
+	OwnedValue() : value(nullptr) {}
+	explicit OwnedValue(int32_t _value) : value(new int32_t(_value)) {}
+	OwnedValue(OwnedValue&& other) noexcept : value(other.value) { other.value = nullptr; ++moveCount; }
+	OwnedValue(const OwnedValue& other) = delete;
+	~OwnedValue() { delete value; }
+
+	OwnedValue& operator= (OwnedValue&& other) noexcept {
+		std::swap(value, other.value);
+		return *this;
+	}
+};
+
+int32_t OwnedValue::moveCount = 0;
+
+template <>
+struct is_trivially_relocatable<OwnedValue> : std::true_type {};
+
+static_assert(not is_trivially_relocatable_v<SelfRef>, "SelfRef must be relocated by moving");
+
+
+template <typename ARRAY_T>
+static bool IsIntact(ARRAY_T& a, int32_t length) {
+	bool isIntact = (a.Length() >= length);
+	for (int32_t i = 0; isIntact and (i < length); i++)
+		isIntact = a[i].IsIntact();
+	return isIntact;
+}
+
+
+static void TestRelocation(void) {
+	{
+		// growing, reserving, shrinking, sorting and moving inline storage relocate by move construction
+		ManagedArray<SelfRef> a;
+		int32_t liveCount = SelfRef::liveCount;	// the array holds a default element of its own
+		for (int32_t i = 0; i < 1000; i++)
+			a.Append(SelfRef((i * 37) % 1000));
+		CHECK(IsIntact(a, 1000) and (SelfRef::liveCount == liveCount + 1000));
+		a.Reserve(5000);
+		CHECK(IsIntact(a, 1000) and (a[999].value == (999 * 37) % 1000));
+		a.Resize(700);
+		a.ShrinkToFit();
+		CHECK(IsIntact(a, 700) and (SelfRef::liveCount == liveCount + 700));
+		a.SortBy(SortLess());
+		bool isSorted = true;
+		for (int32_t i = 1; i < 700; i++)
+			isSorted = isSorted and not (a[i] < a[i - 1]);
+		CHECK(IsIntact(a, 700) and isSorted);
+		a.SortBy(SortGreater(), 0, 0, true, true);
+		CHECK(IsIntact(a, 700) and (a[0].value == 999) and (SelfRef::liveCount == liveCount + 700));
+
+		SmallArray<SelfRef, 4> inlineArray;
+		for (int32_t i = 0; i < 3; i++)
+			inlineArray.Append(SelfRef(i));
+		SmallArray<SelfRef, 4> moved(std::move(inlineArray));
+		CHECK(moved.IsInline() and IsIntact(moved, 3) and (moved[2].value == 2));
+
+		// deleting from a stack shifts the elements behind by move assignment
+		Stack<SelfRef> stack;
+		for (int32_t i = 0; i < 10; i++)
+			stack.Push(SelfRef(i));
+		CHECK(stack.Delete(3));
+		CHECK((stack.ToS() == 9) and IsIntact(stack, 9) and (stack[3].value == 4) and (stack[8].value == 9));
+	}
+	CHECK(SelfRef::liveCount == 0);
+
+	{
+		// opted in elements are relocated without moving them
+		ManagedArray<OwnedValue> a;
+		for (int32_t i = 0; i < 1000; i++)
+			a.Append(OwnedValue(i));
+		int32_t moveCount = OwnedValue::moveCount;
+		a.Reserve(4000);
+		a.ShrinkToFit();
+		CHECK(OwnedValue::moveCount == moveCount);
+		bool isIntact = true;
+		for (int32_t i = 0; i < 1000; i++)
+			isIntact = isIntact and a[i].value and (*a[i].value == i);
+		CHECK(isIntact);
+		Stack<OwnedValue> stack;
+		for (int32_t i = 0; i < 10; i++)
+			stack.Push(OwnedValue(i));
+		CHECK(stack.Delete(0));
+		CHECK((*stack[0].value == 1) and (*stack[8].value == 9));
+	}	// a leak checker reports values lost or freed twice by the relocations
+}
+
+// =================================================================================================
+// MappedArray
+
+struct MappedRecord {
+	int32_t	id;
+	float	weight;
+	double	position[2];
+};
+
+
+static bool IsRecord(const MappedRecord& r, int32_t i) {
+	return (r.id == i) and (r.weight == float(i) * 0.5f) and (r.position[0] == double(i)) and (r.position[1] == -double(i));
+}
+
+
+template <typename ARRAY_T>
+static bool HasRecords(ARRAY_T& a, int32_t count) {
+	bool hasRecords = (a.Length() == count);
+	for (int32_t i = 0; hasRecords and (i < count); i++)
+		hasRecords = IsRecord(a[i], i);
+	return hasRecords;
+}
+
+
+static void TestMappedArray(void) {
+	const char* path = "containertest_mapped.bin";
+	const int32_t count = 10000;
+	ManagedArray<MappedRecord> records;
+	for (int32_t i = 0; i < count; i++)
+		records.Append(MappedRecord { i, float(i) * 0.5f, { double(i), -double(i) } });
+	CHECK(records.Save(path));
+
+	// the mapped elements are the saved ones
+	{
+		MappedArray<MappedRecord> mapped(path);
+		CHECK(mapped.IsOpen() and mapped.IsMapped() and (mapped.GetMode() == MappedFile::Mode::ReadOnly));
+		CHECK(HasRecords(mapped, count));
+		CHECK(mapped.Advise(MappedFile::Access::Random, 100, 1000));
+		// a copy on write mapping changes the elements in memory only
+		MappedArray<MappedRecord> changed(path, MappedFile::Mode::CopyOnWrite, MappedFile::Access::Sequential);
+		CHECK(changed.IsMapped() and HasRecords(changed, count));
+		changed[5].id = -5;
+		CHECK((changed[5].id == -5) and IsRecord(mapped[5], 5));
+		// growing beyond the file moves the elements to the heap
+		changed.Append(MappedRecord { count, float(count) * 0.5f, { double(count), -double(count) } });
+		CHECK(not changed.IsMapped() and changed.IsOpen() and (changed.Length() == count + 1));
+		CHECK((changed[5].id == -5) and IsRecord(changed[count - 1], count - 1) and IsRecord(changed[count], count));
+	}
+	MappedArray<MappedRecord> reopened;
+	CHECK(reopened.Open(path) and HasRecords(reopened, count));
+	reopened.Close();
+	CHECK(not reopened.IsOpen() and (reopened.Length() == 0));
+
+	// files that are not a whole number of elements are rejected, empty files have no elements
+	CHECK(MappedFile::Write(path, records.Data(), sizeof(MappedRecord) + 1));
+	CHECK(not reopened.Open(path) and not reopened.IsOpen());
+	CHECK(MappedFile::Write(path, records.Data(), 0));
+	CHECK(reopened.Open(path) and (reopened.Length() == 0) and not reopened.IsMapped());
+	reopened.Close();
+	remove(path);
+	CHECK(not reopened.Open(path));
+}
+
+// =================================================================================================
+// SmallArray and SmallStack
+
+// Fills rounds arrays with count ints each, the way neighbour lists are built; returns the seconds
+// taken and counts the arrays that needed a heap buffer.
+template <typename ARRAY_T>
+static double FillArrays(int32_t rounds, int32_t count, int32_t& heapBuffers) {
+	heapBuffers = 0;
+	int64_t sum = 0;
+	BenchTimer timer;
+	for (int32_t r = 0; r < rounds; r++) {
+		ARRAY_T a;
+		for (int32_t i = 0; i < count; i++)
+			a.Append(i);
+		sum += a[count - 1];
+		heapBuffers += not a.IsInline();
+	}
+	CHECK(sum == int64_t(rounds) * (count - 1));
+	return timer.Elapsed();
+}
+
+
+static void TestSmallArray(bool bench) {
+	SmallArray<std::string, 4> a;
+	for (int32_t i = 0; i < 4; i++)
+		a.Append(std::to_string(i));
+	CHECK(a.IsInline() and (a.Capacity() == 4));
+	SmallArray<std::string, 4> copy(a);
+	a.Append(std::string("4"));		// spills to the heap
+	CHECK(not a.IsInline() and (a.Length() == 5) and (a[0] == "0") and (a[4] == "4"));
+	CHECK(copy.IsInline() and (copy.Length() == 4) and (copy[3] == "3"));
+	SmallArray<std::string, 4> moved(std::move(a));
+	CHECK((moved.Length() == 5) and (moved[2] == "2"));
+	moved.Resize(3);
+	moved.ShrinkToFit();			// back into the inline storage
+	CHECK(moved.IsInline() and (moved.Length() == 3) and (moved[2] == "2"));
+
+	SmallStack<int32_t, 8> stack;
+	for (int32_t i = 0; i < 8; i++)
+		stack.Push(i);
+	CHECK(stack.IsInline());
+	stack.Push(8);
+	CHECK(not stack.IsInline() and (stack.ToS() == 9));
+	bool isLifo = true;
+	for (int32_t i = 8; i >= 0; i--)
+		isLifo = isLifo and (stack.Pop() == i);
+	CHECK(isLifo and (stack.ToS() == 0));
+
+	if (bench) {
+		const int32_t rounds = 1000000;
+		for (int32_t count : { 2, 4, 8, 16 }) {
+			int32_t managedBuffers, smallBuffers;
+			double managedTime = FillArrays<ManagedArray<int32_t>>(rounds, count, managedBuffers);
+			double smallTime = FillArrays<SmallArray<int32_t, 8>>(rounds, count, smallBuffers);
+			printf("%d arrays of %d ints: ManagedArray %.2f ms (%d heap buffers), SmallArray<8> %.2f ms (%d heap buffers)\n",
+				rounds, count, managedTime * 1000, managedBuffers, smallTime * 1000, smallBuffers);
+		}
+	}
+}
+
+// =================================================================================================
+// ThreadPool and Array2D
+
+static void TestThreadPool(void) {
+	// loops nested in tasks run serially on the thread running the task, whichever thread that is
+	ThreadPool pool(3);
+	std::atomic<int32_t> count = 0;
+	pool.ParallelFor(64, [&](int32_t) {
+		pool.ParallelFor(16, [&](int32_t) { ++count; });
+		});
+	CHECK(count == 64 * 16);
+	count = 0;
+	pool.ParallelFor(1000, [&](int32_t i) { count += i; });
+	CHECK(count == 999 * 1000 / 2);
+}
+
+
+struct Rgb {
+	float	r, g, b;
+};
+
+
+static void TestArray2D(void) {
+	// rows start on cache lines also for element sizes that do not divide the cache line size
+	Array2D<Rgb> grid(37, 9);
+	for (int32_t y = 0; y < grid.Rows(); y++)
+		CHECK(uintptr_t(grid.GetRow(y)) % Array2D<Rgb>::CACHE_LINE_SIZE == 0);
+	Array2D<double> values(5, 3);
+	CHECK(values.GetRow(1) == values.GetRow(0) + 8);
+
+	// every layout maps the grid one to one, and the walks visit every element once
+	using Grid = Array2D<int32_t>;
+	for (Grid::Layout layout : { Grid::Layout::RowMajor, Grid::Layout::Tiled, Grid::Layout::Morton }) {
+		Grid grid(37, 21, layout);
+		grid.ForEach([](int32_t x, int32_t y, int32_t& element) { element = x + 1000 * y; }, true);
+		grid.Transform([](const int32_t& element) { return element + 1; }, true);
+		bool isMapped = true;
+		for (int32_t y = 0; y < grid.Rows(); y++)
+			for (int32_t x = 0; x < grid.Cols(); x++)
+				isMapped = isMapped and (grid(x, y) == x + 1000 * y + 1);
+		CHECK(isMapped);
+	}
+}
+
+
+// Sum a cols x rows grid column by column, the access pattern the tiled layouts are meant for.
+template <typename GRID_T>
+static double WalkColumns(GRID_T& grid, int32_t cols, int32_t rows, int64_t& sum) {
+	BenchTimer timer;
+	for (int32_t x = 0; x < cols; x++)
+		for (int32_t y = 0; y < rows; y++)
+			sum += grid(x, y);
+	return timer.Elapsed();
+}
+
+
+// plain row major grid without padding, as Array2D was before it had layouts
+class PlainGrid {
+	ManagedArray<int32_t>	m_data;
+	int32_t					m_cols;
+
+public:
+	PlainGrid(int32_t cols, int32_t rows) : m_cols(cols) {
+		m_data.Resize(cols * rows);
+	}
+
+	inline int32_t& operator()(int32_t x, int32_t y) {
+		return m_data[y * m_cols + x];
+	}
+};
+
+
+static void BenchArray2D(void) {
+	const int32_t cols = 4000, rows = 4000;
+	using Grid = Array2D<int32_t>;
+	int64_t sum = 0;
+	PlainGrid plain(cols, rows);
+	double plainTime = WalkColumns(plain, cols, rows, sum);
+	Grid rowMajor(cols, rows, Grid::Layout::RowMajor);
+	double rowMajorTime = WalkColumns(rowMajor, cols, rows, sum);
+	Grid tiled(cols, rows, Grid::Layout::Tiled);
+	double tiledTime = WalkColumns(tiled, cols, rows, sum);
+	Grid morton(cols, rows, Grid::Layout::Morton);
+	double mortonTime = WalkColumns(morton, cols, rows, sum);
+	CHECK(sum == 0);
+	printf("walk %d x %d ints by columns: unpadded %.2f ms, RowMajor %.2f ms, Tiled %.2f ms, Morton %.2f ms\n",
+		cols, rows, plainTime * 1000, rowMajorTime * 1000, tiledTime * 1000, mortonTime * 1000);
+}
+
+// =================================================================================================
+// IntroSort
+
+// McIlroy's adversary for quicksorts: the values of the items are decided while the sort compares
+// them, always so that the pivot candidate ends up next to the smallest value. A plain median of
+// three quicksort takes quadratic time on it; the values it settles on are a killer input for the
+// sort at hand.
+class SortAdversary {
+public:
+	std::vector<int32_t>	m_values;
+	int32_t	m_gas;			// value of items not decided yet, greater than all decided values
+	int32_t	m_solidCount = 0;
+	int32_t	m_candidate = 0;
+	int64_t	m_comparisons = 0;
+
+	explicit SortAdversary(int32_t count) : m_values(count, count), m_gas(count) {}
+
+	bool Less(int32_t a, int32_t b) {
+		++m_comparisons;
+		if ((m_values[a] == m_gas) and (m_values[b] == m_gas))
+			m_values[(a == m_candidate) ? a : b] = m_solidCount++;
+		if (m_values[a] == m_gas)
+			m_candidate = a;
+		else if (m_values[b] == m_gas)
+			m_candidate = b;
+		return m_values[a] < m_values[b];
+	}
+};
+
+
+// inputs that degrade quicksorts with simple pivot choices
+static std::vector<int32_t> SortInput(int32_t pattern, int32_t count, std::mt19937& random) {
+	std::vector<int32_t> values(count);
+	for (int32_t i = 0; i < count; i++) {
+		switch (pattern) {
+			case 0: values[i] = int32_t(random()); break;
+			case 1: values[i] = i; break;								// sorted
+			case 2: values[i] = count - i; break;						// reversed
+			case 3: values[i] = 42; break;								// all equal
+			case 4: values[i] = int32_t(random() % 4); break;			// few distinct values
+			case 5: values[i] = std::min(i, count - i); break;			// organ pipe
+			case 6: values[i] = i % 1000; break;						// sawtooth
+			case 7: values[i] = (i % 2) ? i : count - i; break;			// interleaved ascending and descending
+		}
+	}
+	return values;
+}
+
+static const char* sortInputNames[] = { "random", "sorted", "reversed", "equal", "few values", "organ pipe", "sawtooth", "interleaved", "adversary" };
+
+
+static void TestIntroSort(bool bench) {
+	// the adversary cannot push the comparisons past O(n log n): the depth limit hands badly split
+	// ranges to heapsort. At most 2 log2 n levels of partitioning and the heapsort take about
+	// 2 n log2 n comparisons each; without the depth limit the adversary forces some 500 n log2 n.
+	const int32_t count = 100000;
+	double nLogN = double(count) * std::log2(double(count));
+	SortAdversary adversary(count);
+	std::vector<int32_t> items(count);
+	for (int32_t i = 0; i < count; i++)
+		items[i] = i;
+	QuickSort<int32_t>::Sort(items.data(), 0, count - 1, [&](int32_t a, int32_t b) { return adversary.Less(a, b); });
+	CHECK(adversary.m_comparisons < int64_t(4 * nLogN));
+	bool isSorted = true;
+	for (int32_t i = 1; i < count; i++)
+		isSorted = isSorted and (adversary.m_values[items[i - 1]] <= adversary.m_values[items[i]]);
+	CHECK(isSorted);
+	std::vector<int32_t>& killer = adversary.m_values;
+
+	// all inputs, the adversary's included, sort like std::sort with O(n log n) comparisons
+	std::mt19937 random(49);
+	for (int32_t pattern = 0; pattern < 9; pattern++) {
+		std::vector<int32_t> values = (pattern < 8) ? SortInput(pattern, count, random) : killer;
+		std::vector<int32_t> expected = values;
+		std::sort(expected.begin(), expected.end());
+		int64_t comparisons = 0;
+		QuickSort<int32_t>::Sort(values.data(), 0, count - 1, [&](int32_t a, int32_t b) { ++comparisons; return a < b; });
+		CHECK(values == expected);
+		if (comparisons >= int64_t(4 * nLogN))
+			fprintf(stderr, "%s input: %lld comparisons\n", sortInputNames[pattern], (long long) comparisons);
+		CHECK(comparisons < int64_t(4 * nLogN));
+	}
+	// descending, and the small sizes the insertion sort handles alone
+	for (int32_t n : { 0, 1, 2, 3, 15, 16, 17, 127, 128, 129 }) {
+		std::vector<int32_t> values = SortInput(0, n, random);
+		std::vector<int32_t> expected = values;
+		std::sort(expected.begin(), expected.end(), std::greater<int32_t>());
+		QuickSort<int32_t>::SortDescending(values.data(), 0, n - 1);
+		CHECK(values == expected);
+	}
+
+	if (bench) {
+		const int32_t benchCount = 1000000;
+		SortAdversary benchAdversary(benchCount);
+		std::vector<int32_t> benchItems(benchCount);
+		for (int32_t i = 0; i < benchCount; i++)
+			benchItems[i] = i;
+		QuickSort<int32_t>::Sort(benchItems.data(), 0, benchCount - 1, [&](int32_t a, int32_t b) { return benchAdversary.Less(a, b); });
+		for (int32_t pattern = 0; pattern < 9; pattern++) {
+			std::vector<int32_t> values = (pattern < 8) ? SortInput(pattern, benchCount, random) : benchAdversary.m_values;
+			std::vector<int32_t> copy = values;
+			auto less = [](int32_t a, int32_t b) { return a < b; };
+			BenchTimer introTimer;
+			QuickSort<int32_t>::Sort(values.data(), 0, benchCount - 1, less);
+			double introTime = introTimer.Elapsed();
+			BenchTimer stdTimer;
+			std::sort(copy.begin(), copy.end(), less);
+			double stdTime = stdTimer.Elapsed();
+			CHECK(values == copy);
+			printf("sort %d ints, %s: IntroSort %.2f ms, std::sort %.2f ms\n", benchCount, sortInputNames[pattern], introTime * 1000, stdTime * 1000);
+		}
+	}
+}
+
+// =================================================================================================
+// ParallelMergeSort
+
+// sort element without a default constructor, whose string member dangles if it is not relocated properly
+class SortItem {
+public:
+	int32_t		key;
+	int32_t		index;
+	std::string	text;
+
+	SortItem(int32_t _key, int32_t _index) : key(_key), index(_index), text(std::to_string(_index)) {}
+};
+
+
+static void TestParallelSort(bool bench) {
+	std::mt19937 random(50);
+	auto less = [](const SortItem& a, const SortItem& b) { return a.key < b.key; };
+	for (int32_t threadCount : { 1, 3, 7 }) {
+		ThreadPool pool(threadCount);
+		// the larger sizes are split into several chunks per thread, with uneven chunk sizes
+		for (int32_t count : { 1000, 2 * ParallelMergeSort<SortItem, decltype(less)>::MIN_CHUNK_SIZE * threadCount + 3, 400001 }) {
+			for (bool stable : { false, true }) {
+				std::vector<SortItem> items;
+				items.reserve(count);
+				for (int32_t i = 0; i < count; i++)
+					items.emplace_back(int32_t(random() % 1000), i);	// many equal keys
+				std::vector<SortItem> expected = items;
+				std::stable_sort(expected.begin(), expected.end(), less);
+				ParallelMergeSort<SortItem, decltype(less)>::Sort(items.data(), count, less, stable, pool);
+				bool isSorted = true, isIntact = true, isStable = true;
+				for (int32_t i = 0; i < count; i++) {
+					isSorted = isSorted and (items[i].key == expected[i].key);
+					isIntact = isIntact and (items[i].text == std::to_string(items[i].index));
+					isStable = isStable and (items[i].index == expected[i].index);
+				}
+				CHECK(isSorted);
+				CHECK(isIntact);
+				CHECK(isStable or not stable);
+			}
+		}
+	}
+
+	if (bench) {
+		const int32_t count = 4000000;
+		std::vector<int32_t> values(count);
+		for (int32_t& v : values)
+			v = int32_t(random());
+		std::vector<int32_t> sorted = values;
+		auto intLess = [](const int32_t& a, const int32_t& b) { return a < b; };
+		BenchTimer sortTimer;
+		std::sort(sorted.begin(), sorted.end(), intLess);
+		double sortTime = sortTimer.Elapsed();
+		sorted = values;
+		BenchTimer parallelTimer;
+		ParallelMergeSort<int32_t, decltype(intLess)>::Sort(sorted.data(), count, intLess, false);
+		double parallelTime = parallelTimer.Elapsed();
+		CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+		printf("sort %d ints: std::sort %.2f ms, ParallelMergeSort (%d threads) %.2f ms",
+			count, sortTime * 1000, ThreadPool::Instance().ThreadCount(), parallelTime * 1000);
+#ifdef __cpp_lib_parallel_algorithm
+		// the standard library's parallel sort, for reference (libstdc++ runs it serially when TBB is not available)
+		sorted = values;
+		BenchTimer standardTimer;
+		std::sort(std::execution::par, sorted.begin(), sorted.end(), intLess);
+		double standardTime = standardTimer.Elapsed();
+		CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+		printf(", std::sort(std::execution::par) %.2f ms", standardTime * 1000);
+#endif
+		printf("\n");
+	}
+}
+
+// =================================================================================================
+// MonotonicArena
+
+static void TestMonotonicArena(void) {
+	MonotonicArena arena(1024);
+	arena.Alloc(100);
+	// the inner scope ends after the outer one, which released the inner scope's chunk
+	ArenaScope* outer = new ArenaScope(arena);
+	arena.Alloc(2000);
+	ArenaScope* inner = new ArenaScope(arena);
+	arena.Alloc(100);
+	delete outer;
+	void* p = arena.Alloc(100);
+	delete inner;
+	CHECK(arena.Alloc(100) != p);	// the inner scope did not release p
+
+	// same, with the released chunk taken into use again before the inner scope ends
+	outer = new ArenaScope(arena);
+	arena.Alloc(2000);
+	inner = new ArenaScope(arena);
+	delete outer;
+	arena.Alloc(2000);
+	p = arena.Alloc(10);
+	delete inner;
+	CHECK(arena.Alloc(10) != p);
+
+	// in order scopes release what was allocated in them
+	{
+		ArenaScope scope(arena);
+		p = arena.Alloc(100);
+	}
+	CHECK(arena.Alloc(100) == p);
+}
+
+// =================================================================================================
+// List
+
+static void TestListNodePool(void) {
+	List<int32_t> owner;
+	{
+		List<int32_t> user;
+		CHECK(user.SetNodePool(&owner.GetNodePool()));
+		CHECK(owner.GetNodePool().UserCount() == 1);
+		for (int32_t i = 0; i < 100; i++)
+			user.Append(i);
+		List<int32_t> part = user.Splice(10, 19);
+		CHECK((part.Length() == 10) and (owner.GetNodePool().UserCount() == 2));
+		CHECK(not user.SetNodePool(nullptr));	// not empty
+	}
+	// the lists sharing owner's pool are gone, so owner may destroy it
+	CHECK(owner.GetNodePool().UserCount() == 0);
+
+	// moving a list whose pool is shared must not hand that pool's chunks to the target list
+	List<int32_t>* source = new List<int32_t>;
+	List<int32_t> user;
+	CHECK(user.SetNodePool(&source->GetNodePool()));
+	for (int32_t i = 0; i < 10; i++) {
+		source->Append(i);
+		user.Append(i + 10);
+	}
+	List<int32_t> target;
+	target.Concatenate(std::move(*source));
+	CHECK((target.Length() == 10) and (source->Length() == 0));
+	{
+		List<int32_t> moved = std::move(target);
+		List<int32_t> appended;
+		appended.Append(-1);
+		appended.Concatenate(std::move(moved));
+		CHECK((appended.Length() == 11) and (appended[10] == 9));
+	}	// frees the target's chunks; user's nodes are not among them
+	int32_t sum = 0;
+	for (int32_t i : user)
+		sum += i;
+	CHECK(sum == 145);
+	user.Destroy();
+	delete source;
+
+	// splicing between lists with separate pools copies the nodes; the cached index must not go stale
+	List<int32_t> a, b;
+	for (int32_t i = 0; i < 10; i++)
+		a.Append(i);
+	for (int32_t i = 100; i < 104; i++)
+		b.Append(i);
+	CHECK(a[5] == 5);	// caches node 5
+	CHECK(a.SpliceRange(a.First()->Succ()->Succ(), b, b.First(), b.First()->Succ(), 2));
+	CHECK((a.Length() == 12) and (b.Length() == 2));
+	CHECK((a[5] == 3) and (a[2] == 100) and (b[0] == 102));
+}
+
+
+template <typename ITEM_T>
+static bool Matches(List<ITEM_T>& list, const std::vector<ITEM_T>& model) {
+	if (list.Length() != int32_t(model.size()))
+		return false;
+	int32_t i = 0;
+	for (const ITEM_T& v : list)
+		if (v != model[i++])
+			return false;
+	return true;
+}
+
+
+static void TestListFinger(void) {
+	// indexed reads move the finger around; the edits in between insert and remove items before,
+	// at and behind it, so any index it keeps stale shows up in the reads that follow
+	std::mt19937 random(38);
+	List<int32_t> list;
+	std::vector<int32_t> model;
+	int32_t nextValue = 0;
+	for (int32_t i = 0; i < 200; i++) {
+		list.Append(nextValue);
+		model.push_back(nextValue++);
+	}
+	bool isConsistent = true;
+	for (int32_t round = 0; round < 20000; round++) {
+		int32_t length = int32_t(model.size());
+		int32_t finger = length ? int32_t(random() % length) : 0;
+		if (length)
+			isConsistent = isConsistent and (list[finger] == model[finger]);
+		// edit close to the finger most of the time
+		int32_t at = std::max(0, std::min(length - 1, finger + int32_t(random() % 5) - 2));
+		switch (random() % 8) {
+			case 0:
+			case 1:
+				list.Insert(at, nextValue);
+				model.insert(model.begin() + at, nextValue++);
+				break;
+			case 2:
+				if (length) {
+					list.Discard(at);
+					model.erase(model.begin() + at);
+				}
+				break;
+			case 3:
+				if (length) {
+					isConsistent = isConsistent and (list.Extract(at) == model[at]);
+					model.erase(model.begin() + at);
+				}
+				break;
+			case 4:
+				list.InsertBefore(list.begin() + at, nextValue);
+				model.insert(model.begin() + std::min(at, length), nextValue++);
+				break;
+			case 5:
+				if (length) {
+					list.Discard(list.begin() + at);
+					model.erase(model.begin() + at);
+				}
+				break;
+			case 6:
+				if (random() % 20 == 0) {
+					int32_t divisor = 5 + int32_t(random() % 5);
+					list.RemoveIf([&](int32_t v) { return v % divisor == 0; });
+					model.erase(std::remove_if(model.begin(), model.end(), [&](int32_t v) { return v % divisor == 0; }), model.end());
+				}
+				break;
+			case 7:
+				if (random() % 50 == 0) {
+					list.SortAscending();
+					std::sort(model.begin(), model.end());
+				}
+				break;
+		}
+		// read back around the edit, and the ends of the list
+		length = int32_t(model.size());
+		for (int32_t i = std::max(0, at - 3); i < std::min(length, at + 4); i++)
+			isConsistent = isConsistent and (list[i] == model[i]);
+		if (length)
+			isConsistent = isConsistent and (list[0] == model[0]) and (list[-1] == model[length - 1]);
+		if (length < 50) {	// keep the list from running empty
+			list.Append(nextValue);
+			model.push_back(nextValue++);
+		}
+	}
+	CHECK(isConsistent);
+	CHECK(Matches(list, model));
+}
+
+
+struct KeyedItem {
+	int32_t	key;
+	int32_t	sequence;	// position before sorting
+};
+
+
+static int __cdecl CompareKeys(const KeyedItem* a, const KeyedItem* b) {
+	return (a->key < b->key) ? -1 : (a->key > b->key) ? 1 : 0;
+}
+
+
+static void TestListSort(void) {
+	// equal keys keep their order in both directions, for lengths around powers of two (where the
+	// last runs are merged unevenly) and presorted, reversed and constant input; the items' nodes
+	// are relinked, so the items do not move in memory
+	std::mt19937 random(40);
+	for (int32_t length : { 0, 1, 2, 3, 255, 256, 257, 4097 }) {
+		for (int32_t pattern = 0; pattern < 4; pattern++) {
+			for (int direction : { 1, -1 }) {
+				List<KeyedItem> list;
+				std::vector<KeyedItem> model;
+				std::vector<KeyedItem*> addresses;
+				for (int32_t i = 0; i < length; i++) {
+					int32_t key = (pattern == 0) ? int32_t(random() % 16) : (pattern == 1) ? i / 3 : (pattern == 2) ? (length - i) / 3 : 7;
+					addresses.push_back(list.Append(KeyedItem { key, i }));
+					model.push_back(KeyedItem { key, i });
+				}
+				list.Sort(CompareKeys, direction);
+				std::stable_sort(model.begin(), model.end(), [&](const KeyedItem& a, const KeyedItem& b) { return direction * CompareKeys(&a, &b) < 0; });
+				bool isStable = (list.Length() == length), isInPlace = true;
+				int32_t i = 0;
+				for (KeyedItem& item : list) {
+					isStable = isStable and (item.key == model[i].key) and (item.sequence == model[i].sequence);
+					isInPlace = isInPlace and (&item == addresses[item.sequence]);
+					++i;
+				}
+				CHECK(isStable);
+				CHECK(isInPlace);
+			}
+		}
+	}
+}
+
+
+static void TestListIterators(void) {
+	List<std::string> list;
+	for (int32_t i = 0; i < 10; i++)
+		list.Append(std::to_string(i));
+	std::vector<std::string> model;
+	for (const std::string& s : list)
+		model.push_back(s);
+
+	// inserting and discarding at the front, in the middle and at the end; iterators to other items stay valid
+	List<std::string>::Iterator five = list.begin() + 5;
+	List<std::string>::Iterator it = list.InsertBefore(list.begin(), std::string("front"));
+	CHECK((it == list.begin()) and (*it == "front"));
+	model.insert(model.begin(), "front");
+	it = list.InsertBefore(five, std::string("middle"));
+	CHECK((*it == "middle") and (*++it == "5") and (it == five));
+	model.insert(model.begin() + 6, "middle");
+	it = list.InsertBefore(list.end(), std::string("back"));
+	CHECK((*it == "back") and (++it == list.end()));
+	model.push_back("back");
+	CHECK(list.InsertBefore(List<std::string>::Iterator(list.GetHead()), std::string("x")) == list.end());	// not in front of the head
+	it = list.Discard(five);
+	CHECK(*it == "6");
+	model.erase(model.begin() + 7);
+	CHECK(list.Discard(list.end()) == list.end());
+	it = list.Discard(--list.end());
+	CHECK(it == list.end());
+	model.pop_back();
+	CHECK(list.Extract(list.begin()) == "front");
+	model.erase(model.begin());
+	CHECK(Matches(list, model) and (list[5] == model[5]));
+
+	// discarding while iterating, and removing by predicate
+	for (List<std::string>::Iterator i = list.begin(); i != list.end(); ) {
+		if (i->size() > 1)
+			i = list.Discard(i);
+		else
+			++i;
+	}
+	model.erase(std::remove_if(model.begin(), model.end(), [](const std::string& s) { return s.size() > 1; }), model.end());
+	CHECK(Matches(list, model));
+	CHECK(list.RemoveIf([](const std::string& s) { return (s[0] - '0') % 2 == 0; }) == 5);
+	model.erase(std::remove_if(model.begin(), model.end(), [](const std::string& s) { return (s[0] - '0') % 2 == 0; }), model.end());
+	CHECK(Matches(list, model));
+	CHECK(list.RemoveIf([](const std::string&) { return false; }) == 0);
+	std::vector<std::string> reversed(list.rbegin(), list.rend());
+	CHECK(std::equal(reversed.begin(), reversed.end(), model.rbegin(), model.rend()));
+
+	// once the pool has grown, inserting and discarding recycles its nodes
+	int32_t nodeCount = list.GetNodePool().NodeCount();
+	for (int32_t i = 0; i < 1000; i++)
+		list.Discard(list.InsertBefore(list.begin() + i % 4, std::string("temporary")));
+	CHECK(list.GetNodePool().NodeCount() == nodeCount);
+	CHECK(Matches(list, model));
+}
+
+// =================================================================================================
+// SegmentedList
+
+static bool Matches(const SegmentedList<std::string>& list, const std::vector<std::string>& model) {
+	if (list.Length() != int32_t(model.size()))
+		return false;
+	int32_t i = 0;
+	for (const std::string& s : list)
+		if (s != model[i++])
+			return false;
+	return i == list.Length();
+}
+
+
+static void TestSegmentedList(bool bench) {
+	// with segments of 8 items, filling a list and inserting in the middle splits full segments;
+	// removing items merges neighbours that fill at most half a segment together
+	SegmentedList<std::string> list("", 8);
+	std::vector<std::string> model;
+	for (int32_t i = 0; i < 32; i++) {
+		list.Append(std::to_string(i));
+		model.push_back(std::to_string(i));
+	}
+	CHECK(list.SegmentCount() == 4);
+	list.Insert(3, std::string("a"));	// splits the first segment
+	model.insert(model.begin() + 3, "a");
+	list.Insert(13, std::string("b"));	// splits the second segment, inserting into the upper half
+	model.insert(model.begin() + 13, "b");
+	CHECK(list.SegmentCount() == 6);
+	CHECK(Matches(list, model));
+	// the first two segments now hold 5 and 4 items; they merge once they are down to 2 + 2
+	for (int32_t i : { 5, 5, 0, 0, 0 }) {
+		CHECK(list.Extract(i) == model[i]);
+		model.erase(model.begin() + i);
+	}
+	CHECK(list.SegmentCount() == 5);
+	CHECK(Matches(list, model));
+	CHECK(list[-1] == "31");
+
+	// random inserts and removals against a vector
+	std::mt19937 random(37);
+	for (int32_t i = 0; i < 20000; i++) {
+		int32_t length = list.Length();
+		if (random() % 2 or not length) {
+			int32_t j = int32_t(random() % (length + 1));
+			list.Insert(j, std::to_string(i));
+			model.insert(model.begin() + j, std::to_string(i));
+		}
+		else {
+			int32_t j = int32_t(random() % length);
+			CHECK(list.Discard(j));
+			model.erase(model.begin() + j);
+		}
+	}
+	CHECK(Matches(list, model));
+	// every segment but the last is at least a quarter full, or it would have been merged
+	CHECK(list.SegmentCount() <= list.Length() / 2 + 1);
+	CHECK(list.Filter([](const std::string& s) { return s.size() > 2; }) > 0);
+	std::erase_if(model, [](const std::string& s) { return s.size() > 2; });
+	CHECK(Matches(list, model));
+	CHECK(not list.Discard(list.Length()));
+
+	if (bench) {
+		const int32_t count = 200000;
+		const int32_t removals = 2000;
+		std::vector<int32_t> positions(removals);
+		for (int32_t& p : positions)
+			p = int32_t(random() % (count - removals));
+		int64_t sum = 0;
+
+		BenchTimer segmentedTimer;
+		SegmentedList<int32_t> segmented;
+		for (int32_t i = 0; i < count; i++)
+			segmented.Append(i);
+		for (int32_t v : segmented)
+			sum += v;
+		for (int32_t p : positions)
+			segmented.Discard(p);
+		double segmentedTime = segmentedTimer.Elapsed();
+
+		BenchTimer listTimer;
+		List<int32_t> list;
+		for (int32_t i = 0; i < count; i++)
+			list.Append(i);
+		for (int32_t v : list)
+			sum += v;
+		for (int32_t p : positions)
+			list.Discard(p);
+		double listTime = listTimer.Elapsed();
+
+		BenchTimer stdTimer;
+		std::list<int32_t> stdList;
+		for (int32_t i = 0; i < count; i++)
+			stdList.push_back(i);
+		for (int32_t v : stdList)
+			sum += v;
+		for (int32_t p : positions)
+			stdList.erase(std::next(stdList.begin(), p));
+		double stdTime = stdTimer.Elapsed();
+
+		CHECK((segmented.Length() == list.Length()) and (sum == 3 * (int64_t(count) * (count - 1) / 2)));
+		printf("append, iterate %d ints and remove %d at random: SegmentedList %.2f ms, List %.2f ms, std::list %.2f ms\n",
+			count, removals, segmentedTime * 1000, listTime * 1000, stdTime * 1000);
+	}
+}
+
+// =================================================================================================
+// ArenaMemory
+
+// Follow a random cycle through one entry per cache line of a 256 MB arena, with and without huge
+// pages. Nearly every step misses the cache, so the difference is what the huge pages save in TLB
+// misses and page walks.
+static void BenchArenaPages(void) {
+	const size_t arenaSize = size_t(256) << 20;
+	const uint32_t lineSize = 64;
+	const uint32_t lineCount = uint32_t(arenaSize / lineSize);
+	const int32_t steps = 20000000;
+	for (bool useHugePages : { false, true }) {
+		ArenaMemory arena;
+		bool isUsable = arena.Create(ArenaOptions(arenaSize, useHugePages)) and arena.Commit(arena.GetAddress() + arenaSize);
+		CHECK(isUsable);
+		if (not isUsable) {
+			arena.Destroy();
+			continue;
+		}
+		uint32_t* lines = reinterpret_cast<uint32_t*>(arena.GetAddress());
+		const uint32_t stride = lineSize / sizeof(uint32_t);
+		// Sattolo's shuffle gives a single cycle through all lines
+		for (uint32_t i = 0; i < lineCount; i++)
+			lines[i * stride] = i;
+		std::mt19937 random(34);
+		for (uint32_t i = lineCount - 1; i > 0; i--)
+			std::swap(lines[i * stride], lines[(random() % i) * stride]);
+		uint32_t line = 0;
+		BenchTimer timer;
+		for (int32_t i = 0; i < steps; i++)
+			line = lines[line * stride];
+		double time = timer.Elapsed();
+		CHECK(line < lineCount);
+		printf("random walk over %zu MB, %s: %.1f ns per access\n", arenaSize >> 20, arena.BackingName(), time * 1e9 / steps);
+		arena.Destroy();
+	}
+}
+
+// =================================================================================================
+// MemoryManager
+
+// Each of threadCount threads claims blocks of random sizes (a few of them large), fills them with
+// its tag and frees half of them itself; the other half goes to the next thread, which checks the
+// tag and frees them there. Returns the seconds taken; isIntact is cleared if a block was changed
+// by another thread.
+template <typename ALLOCATOR_T>
+static double AllocateAcrossThreads(ALLOCATOR_T& allocator, int32_t threadCount, int32_t rounds, bool& isIntact) {
+	const int32_t batchSize = 64;
+	std::vector<MPSCQueue<uint8_t*>> inboxes(threadCount);
+	std::atomic<bool> isCorrupted = false;
+	BenchTimer timer;
+	std::vector<std::thread> threads;
+	for (int32_t t = 0; t < threadCount; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 random{ uint32_t(t) };
+			auto check = [&](uint8_t* block, uint8_t tag) {
+				uint32_t size;
+				memcpy(&size, block, sizeof(size));
+				for (uint32_t i = sizeof(size); i < size; i++) {
+					if (block[i] != tag) {
+						isCorrupted = true;
+						break;
+					}
+				}
+				allocator.Free(block);
+			};
+			uint8_t tag = uint8_t(t + 1);
+			uint8_t senderTag = uint8_t((t + threadCount - 1) % threadCount + 1);
+			int32_t received = 0;
+			uint8_t* blocks[batchSize];
+			for (int32_t r = 0; r < rounds; r++) {
+				for (int32_t i = 0; i < batchSize; i++) {
+					uint32_t size = (random() % 256 == 0) ? 40000 + random() % 40000 : 8 + random() % 1000;
+					blocks[i] = reinterpret_cast<uint8_t*>(allocator.Alloc(size));
+					if (not blocks[i]) {
+						isCorrupted = true;
+						return;
+					}
+					memcpy(blocks[i], &size, sizeof(size));
+					memset(blocks[i] + sizeof(size), tag, size - sizeof(size));
+				}
+				for (int32_t i = 0; i < batchSize; i++) {
+					if (i & 1)
+						inboxes[(t + 1) % threadCount].Append(blocks[i]);
+					else
+						check(blocks[i], tag);
+				}
+				for (uint8_t* block; inboxes[t].Extract(block, 0); ++received)
+					check(block, senderTag);
+			}
+			for (uint8_t* block; received < rounds * batchSize / 2; ) {
+				if (inboxes[t].Extract(block, 0)) {
+					check(block, senderTag);
+					++received;
+				}
+				else
+					std::this_thread::yield();
+			}
+			});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	isIntact = not isCorrupted;
+	return timer.Elapsed();
+}
+
+
+class MallocAllocator {
+public:
+	void* Alloc(uint32_t size) {
+		return malloc(size);
+	}
+
+	void Free(void* address) {
+		free(address);
+	}
+};
+
+
+static void TestMemoryManagerThreads(bool bench) {
+	MemoryManager& mm = MemoryManager::Instance();
+	CHECK(mm.Create(1000));
+	bool isIntact;
+	AllocateAcrossThreads(mm, 4, bench ? 2000 : 100, isIntact);
+	CHECK(isIntact);
+	CHECK(mm.CheckIntegrity());
+	// the threads' caches were flushed when they ended, so nothing is left in use
+	MemoryStatistics stats;
+	mm.GetStatistics(stats);
+	CHECK((stats.requestedBytes == 0) and (stats.classUsedBytes == 0) and (stats.largeUsedCount == 0));
+
+	if (bench) {
+		const int32_t rounds = 2000;
+		for (int32_t threadCount : { 1, 4 }) {
+			double managerTime = AllocateAcrossThreads(mm, threadCount, rounds, isIntact);
+			MallocAllocator heap;
+			double mallocTime = AllocateAcrossThreads(heap, threadCount, rounds, isIntact);
+			printf("%d threads claiming and freeing %d blocks, half of them freed by the next thread: MemoryManager %.2f ms, malloc %.2f ms\n",
+				threadCount, threadCount * rounds * 64, managerTime * 1000, mallocTime * 1000);
+		}
+	}
+}
+
+
+// =================================================================================================
+// AllocationProfiler
+
+class ReportLine {
+public:
+	unsigned long long	caller = 0;
+	unsigned long long	samples = 0;
+	unsigned long long	sampledBytes = 0;
+	long long			liveSamples = 0;
+	long long			liveBytes = 0;
+	long long			estimatedLiveBytes = 0;
+};
+
+
+// parse the call site lines of a CSV report; false if the report is malformed
+static bool ReadReport(FILE* stream, std::vector<ReportLine>& lines) {
+	char buffer[256];
+	if (not fgets(buffer, sizeof(buffer), stream) or strncmp(buffer, "site,caller,samples,", 20))
+		return false;
+	while (fgets(buffer, sizeof(buffer), stream)) {
+		if (buffer[0] == '#')
+			return true;
+		ReportLine line;
+		unsigned site;
+		if (sscanf(buffer, "%x,0x%llx,%llu,%llu,%lld,%lld,%lld", &site, &line.caller, &line.samples, &line.sampledBytes,
+				   &line.liveSamples, &line.liveBytes, &line.estimatedLiveBytes) != 7)
+			return false;
+		lines.push_back(line);
+	}
+	return false;
+}
+
+
+static bool Report(AllocationProfiler& profiler, std::vector<ReportLine>& lines) {
+	FILE* stream = tmpfile();
+	if (not stream)
+		return false;
+	bool isValid = profiler.Report(stream);
+	rewind(stream);
+	isValid = isValid and ReadReport(stream, lines);
+	fclose(stream);
+	return isValid;
+}
+
+
+static const ReportLine* FindSite(const std::vector<ReportLine>& lines, uintptr_t caller) {
+	for (const ReportLine& line : lines)
+		if (line.caller == caller)
+			return &line;
+	return nullptr;
+}
+
+
+// a call site of its own for the profiled MemoryManager allocations
+#ifdef _MSC_VER
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void* AllocAtSite(uint32_t size) {
+	return MemoryManager::Instance().Alloc(size);
+}
+
+
+static void TestAllocationProfiler(bool bench) {
+	// every 4th allocation of a thread is sampled
+	AllocationProfiler profiler;
+	CHECK(profiler.Create(4));
+	int32_t sampled = 0;
+	for (int32_t i = 0; i < 100; i++)
+		sampled += profiler.Sample();
+	CHECK(sampled == 25);
+
+	// known allocations at two sites, more than the ring holds between drains; every sample is kept
+	CHECK(profiler.Create(1, 8));
+	void* siteA = reinterpret_cast<void*>(uintptr_t(0x1000));
+	void* siteB = reinterpret_cast<void*>(uintptr_t(0x2000));
+	for (uintptr_t i = 1; i <= 10; i++)
+		profiler.RecordAlloc(reinterpret_cast<void*>(i * 16), 100, siteA);
+	for (uintptr_t i = 11; i <= 15; i++)
+		profiler.RecordAlloc(reinterpret_cast<void*>(i * 16), 1000, siteB);
+	for (uintptr_t i = 1; i <= 4; i++)
+		profiler.RecordFree(reinterpret_cast<void*>(i * 16));
+	profiler.RecordFree(reinterpret_cast<void*>(uintptr_t(99 * 16)));	// not sampled; ignored
+	std::vector<ReportLine> lines;
+	CHECK(Report(profiler, lines) and (lines.size() == 2));
+	const ReportLine* a = FindSite(lines, uintptr_t(siteA));
+	const ReportLine* b = FindSite(lines, uintptr_t(siteB));
+	CHECK(a and (a->samples == 10) and (a->sampledBytes == 1000) and (a->liveSamples == 6) and (a->liveBytes == 600));
+	CHECK(b and (b->samples == 5) and (b->sampledBytes == 5000) and (b->liveSamples == 5) and (b->liveBytes == 5000));
+
+	// MemoryManager samples its allocations at their call site; live bytes are scaled by the interval
+	MemoryManager& mm = MemoryManager::Instance();
+	CHECK(mm.Create(1000));
+	CHECK(mm.StartProfiler(2));
+	void* blocks[20];
+	for (void*& block : blocks)
+		block = AllocAtSite(200);
+	for (int32_t i = 0; i < 6; i++)
+		mm.Free(blocks[i]);
+	lines.clear();
+	CHECK(Report(mm.Profiler(), lines) and (lines.size() == 1));
+	if (lines.size() == 1) {
+		const ReportLine& line = lines[0];
+		CHECK((line.samples == 10) and (line.sampledBytes == 2000));
+		CHECK((line.liveSamples == 7) and (line.estimatedLiveBytes == 2 * line.liveBytes) and (line.liveBytes == 1400));
+	}
+
+#ifdef SIGUSR2
+	// SIGUSR2 requests a report, which the next sampled allocation writes
+	char path[] = "containertest_profile.csv";
+	remove(path);
+	CHECK(mm.Profiler().InstallSignalHandler(path));
+	raise(SIGUSR2);
+	void* trigger[2] = { AllocAtSite(10), AllocAtSite(10) };
+	FILE* stream = fopen(path, "r");
+	lines.clear();
+	CHECK(stream and ReadReport(stream, lines) and not lines.empty());
+	if (stream)
+		fclose(stream);
+	remove(path);
+	signal(SIGUSR2, SIG_DFL);
+	for (void* block : trigger)
+		mm.Free(block);
+#endif
+	for (int32_t i = 6; i < 20; i++)
+		mm.Free(blocks[i]);
+	mm.StopProfiler();
+
+	if (bench) {
+		const int32_t rounds = 2000000;
+		auto churn = [&]() {
+			BenchTimer timer;
+			for (int32_t i = 0; i < rounds; i++)
+				mm.Free(AllocAtSite(uint32_t(16 + (i & 255))));
+			return timer.Elapsed();
+		};
+		// alternate and keep the fastest run of each, since the difference is smaller than the noise
+		double offTime = 1e9, onTime = 1e9;
+		for (int32_t i = 0; i < 5; i++) {
+			offTime = std::min(offTime, churn());
+			mm.StartProfiler(1000);
+			onTime = std::min(onTime, churn());
+			mm.StopProfiler();
+		}
+		printf("%d allocations and frees: profiler off %.2f ms, sampling every 1000th %.2f ms (%+.1f%%)\n",
+			rounds, offTime * 1000, onTime * 1000, 100 * (onTime / offTime - 1));
+	}
+}
+
+// =================================================================================================
+// MemoryManager size classes
+
+static void TestSizeClasses(void) {
+	CHECK(MemoryManager::SizeClassIndex(1) == 0);
+	CHECK(MemoryManager::SizeClassSize(SIZE_CLASS_COUNT - 1) == MAX_CLASS_SIZE);
+	CHECK(MemoryManager::SizeClassIndex(MAX_CLASS_SIZE + 1) == -1);
+	// each class is the smallest one holding its size, and one byte more goes to the next class
+	for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+		int32_t classSize = MemoryManager::SizeClassSize(i);
+		CHECK(classSize % 16 == 0);
+		CHECK(MemoryManager::SizeClassIndex(uint32_t(classSize)) == i);
+		CHECK(MemoryManager::SizeClassIndex(uint32_t(classSize) + 1) == ((i + 1 < SIZE_CLASS_COUNT) ? i + 1 : -1));
+		if (i > 0)
+			CHECK(classSize > MemoryManager::SizeClassSize(i - 1));
+	}
+
+	// allocations that fill a class block up to its last byte, and one byte more; writing all
+	// requested bytes must leave the guards of both blocks intact. The smallest class is too small
+	// for a header and guard.
+	MemoryManager& mm = MemoryManager::Instance();
+	CHECK(mm.Create(1000));
+	const uint32_t overhead = uint32_t(sizeof(BlockHeader) + GUARD_SIZE);
+	for (int i = MemoryManager::SizeClassIndex(overhead + 1); i < SIZE_CLASS_COUNT; i++) {
+		uint32_t size = uint32_t(MemoryManager::SizeClassSize(i)) - overhead;
+		char* fitting = reinterpret_cast<char*>(mm.Alloc(size));
+		char* larger = reinterpret_cast<char*>(mm.Alloc(size + 1));
+		CHECK(fitting and larger);
+		if (not (fitting and larger))
+			continue;
+		CHECK(BlockHeader::Of(fitting)->sizeClass == i);
+		CHECK(BlockHeader::Of(larger)->sizeClass == ((i + 1 < SIZE_CLASS_COUNT) ? i + 1 : -1));
+		CHECK((uintptr_t(fitting) % 16 == 0) and (uintptr_t(larger) % 16 == 0));
+		memset(fitting, 0xA5, size);
+		memset(larger, 0x5A, size + 1);
+		CHECK(mm.IsIntact(BlockHeader::Of(fitting)) and mm.IsIntact(BlockHeader::Of(larger)));
+		mm.Free(fitting);
+		mm.Free(larger);
+	}
+	// sizes whose block size does not fit 32 bits fail instead of wrapping around to a small class
+	void* block = mm.Alloc(16);
+	CHECK(mm.Alloc(0xFFFFFFF0u) == nullptr);
+	CHECK(mm.Realloc(block, 0xFFFFFFF0u, true) == block);
+	mm.Free(block);
+	CHECK(mm.CheckIntegrity());
+}
+
+// =================================================================================================
+// MemoryManager Realloc
+
+// fills size bytes of block with a pattern derived from their offset
+static void FillPattern(void* block, uint32_t size) {
+	for (uint32_t i = 0; i < size; i++)
+		reinterpret_cast<uint8_t*>(block)[i] = uint8_t(i * 7 + 3);
+}
+
+
+static bool HasPattern(const void* block, uint32_t size) {
+	for (uint32_t i = 0; i < size; i++)
+		if (reinterpret_cast<const uint8_t*>(block)[i] != uint8_t(i * 7 + 3))
+			return false;
+	return true;
+}
+
+
+static void TestReallocInPlace(void) {
+	MemoryManager& mm = MemoryManager::Instance();
+	CHECK(mm.Create(1000));
+	MemoryStatistics before, after;
+	const uint32_t overhead = uint32_t(sizeof(BlockHeader) + GUARD_SIZE);
+
+	// a class block stays put while the new size fits its class and uses more than half of it
+	mm.GetStatistics(before);
+	void* block = mm.Alloc(1000);
+	FillPattern(block, 1000);
+	uint32_t classSize = uint32_t(MemoryManager::SizeClassSize(BlockHeader::Of(block)->sizeClass));
+	CHECK(mm.Realloc(block, classSize - overhead, true) == block);	// grow to the end of the class
+	CHECK(HasPattern(block, 1000));
+	FillPattern(block, classSize - overhead);
+	CHECK(mm.Realloc(block, classSize / 2 - overhead + 1, true) == block);	// shrink to just above half
+	CHECK(HasPattern(block, classSize / 2 - overhead + 1));
+	CHECK(mm.IsIntact(BlockHeader::Of(block)));
+	mm.GetStatistics(after);
+	CHECK(after.reallocInPlace == before.reallocInPlace + 2);
+	CHECK(after.reallocMoved == before.reallocMoved);
+	// growing past the class or shrinking to half of it moves the data to a fitting class
+	void* grown = mm.Realloc(block, classSize - overhead + 1, true);
+	CHECK((grown != block) and HasPattern(grown, classSize / 2 - overhead + 1));
+	CHECK(BlockHeader::Of(grown)->sizeClass == MemoryManager::SizeClassIndex(classSize + 1));
+	void* shrunk = mm.Realloc(grown, 100, true);
+	CHECK((shrunk != grown) and HasPattern(shrunk, 100));
+	CHECK(BlockHeader::Of(shrunk)->sizeClass == MemoryManager::SizeClassIndex(100 + overhead));
+	mm.Free(shrunk);
+
+	// a large block shrinks in place and hands the tail to the arena; growing it again takes the
+	// tail back, as long as nothing claimed it in between
+	mm.GetStatistics(before);
+	void* large = mm.Alloc(400000);
+	void* fence = mm.Alloc(100000);	// keeps large from being the arena tail, which would grow by reserving
+	FillPattern(large, 400000);
+	CHECK(mm.Realloc(large, 200000, true) == large);
+	CHECK(HasPattern(large, 200000));
+	CHECK(mm.Realloc(large, 350000, true) == large);
+	CHECK(HasPattern(large, 200000));
+	FillPattern(large, 350000);
+	CHECK(mm.Realloc(large, 400000, true) == large);
+	CHECK(HasPattern(large, 350000));
+	CHECK(mm.IsIntact(BlockHeader::Of(large)));
+	mm.GetStatistics(after);
+	CHECK(after.reallocInPlace == before.reallocInPlace + 3);
+	CHECK(after.reallocMoved == before.reallocMoved);
+	CHECK(after.largeUsedCount == before.largeUsedCount + 2);
+	// shrinking into the size class range moves the data to a class block
+	void* small = mm.Realloc(large, 1000, true);
+	CHECK((small != large) and HasPattern(small, 1000));
+	CHECK(BlockHeader::Of(small)->sizeClass >= 0);
+	mm.Free(small);
+	mm.Free(fence);
+	CHECK(mm.CheckIntegrity());
+}
+
+// =================================================================================================
+// MemoryManager slabs and lifetime
+
+// resident memory of the process; 0 where it cannot be determined
+static size_t ResidentBytes(void) {
+	size_t resident = 0;
+#ifdef __linux__
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (statm) {
+		size_t total;
+		if (fscanf(statm, "%zu %zu", &total, &resident) != 2)
+			resident = 0;
+		fclose(statm);
+	}
+	resident *= size_t(sysconf(_SC_PAGESIZE));
+#endif
+	return resident;
+}
+
+
+static void TestSlabRelease(bool bench) {
+	// a thread fills 32 MB of small blocks, claims a large block behind them and frees the small
+	// blocks; the emptied slabs go back to the arena, which discards their pages
+	MemoryManager& mm = MemoryManager::Instance();
+	CHECK(mm.Create(1000));
+	const int32_t blockCount = (32 << 20) / 64;
+	const SizeClass& sc = mm.GetSizeClass(MemoryManager::SizeClassIndex(40 + sizeof(BlockHeader) + GUARD_SIZE));
+	std::vector<void*> blocks(blockCount);
+	void* fence = nullptr;
+	MemoryStatistics full, released, refilled;
+	size_t fullResident = 0, releasedResident = 0;
+	auto fill = [&]() {
+		for (void*& block : blocks) {
+			block = mm.Alloc(40);
+			memset(block, 1, 40);
+		}
+	};
+	std::thread thread([&]() {
+		fill();
+		fence = mm.Alloc(1 << 20);
+		mm.GetStatistics(full);
+		fullResident = ResidentBytes();
+		for (void* block : blocks)
+			mm.Free(block);
+		});
+	thread.join();
+	mm.GetStatistics(released);
+	releasedResident = ResidentBytes();
+	// the current slab and a slab's worth of free blocks may stay with the class
+	CHECK(sc.freeBlockCount <= 3 * sc.slabSize / sc.blockSize);
+	CHECK(released.largeFreeBytes > full.largeFreeBytes + (24 << 20));
+	if (fullResident)
+		CHECK(releasedResident + (16 << 20) < fullResident);
+	CHECK(mm.CheckIntegrity());
+
+	// new slabs are taken from the released memory instead of growing the arena
+	thread = std::thread([&]() {
+		fill();
+		mm.GetStatistics(refilled);
+		for (void* block : blocks)
+			mm.Free(block);
+		mm.Free(fence);
+		});
+	thread.join();
+	CHECK(refilled.reservedBytes == full.reservedBytes);
+	CHECK(mm.CheckIntegrity());
+	if (bench and fullResident)
+		printf("32 MB of small blocks: %zu MB resident while used, %zu MB after they were freed\n", fullResident >> 20, releasedResident >> 20);
+}
+
+
+// thread local object destroyed after the thread's block cache, since it is constructed before
+class LateAllocator {
+public:
+	~LateAllocator() {
+		MemoryManager& mm = MemoryManager::Instance();
+		for (int i = 0; i < 2; i++)
+			mm.Free(mm.Alloc(40));
+	}
+};
+
+static thread_local LateAllocator lateAllocator;
+
+
+// Runs last: it destroys and re-creates the MemoryManager.
+static void TestMemoryManager(void) {
+	MemoryManager& mm = MemoryManager::Instance();
+	CHECK(mm.Create(1000));
+	// blocks claimed and freed after the thread cache was flushed go straight to the size class, so
+	// its used blocks (including those held by this thread's cache) are back where they were
+	const SizeClass& sc = mm.GetSizeClass(MemoryManager::SizeClassIndex(40 + sizeof(BlockHeader) + GUARD_SIZE));
+	int32_t usedBlockCount = sc.usedBlockCount;
+	std::thread thread([&]() {
+		(void) &lateAllocator;
+		mm.Free(mm.Alloc(40));
+		});
+	thread.join();
+	CHECK(sc.usedBlockCount == usedBlockCount);
+
+	// blocks freed after Destroy, e.g. by static objects destroyed after the MemoryManager, stay put
+	void* large = mm.Alloc(1 << 20);
+	void* small = mm.Alloc(40);
+	CHECK(large and small);
+	mm.Destroy();
+	mm.Free(large);
+	mm.Free(small);
+	// and allocating after Destroy fails instead of registering blocks in the released descriptors
+	CHECK(mm.Alloc(40) == nullptr);
+	CHECK(mm.Alloc(1 << 20) == nullptr);
+	CHECK(mm.Realloc(small, 1000, true) == small);
+
+	// creating the manager again maps a new arena; the blocks this thread cached when it claimed
+	// small are dropped
+	CHECK(mm.Create(1000, false));
+	void* block = mm.Alloc(40);
+	CHECK(block and mm.IsArenaAddress(block));
+	mm.Free(block);
+	CHECK(mm.CheckIntegrity());
+}
+
+// =================================================================================================
+
+int main(int argc, char** argv) {
+	bool bench = (argc > 1) and not strcmp(argv[1], "bench");
+	TestBasicDataPool();
+	TestHandles();
+	TestFastDataPool(bench);
+	TestMonotonicArena();
+	TestQueues(bench);
+	TestSimdKernels(bench);
+	TestManagedArray(bench);
+	TestRelocation();
+	TestMappedArray();
+	TestSmallArray(bench);
+	TestThreadPool();
+	TestArray2D();
+	if (bench)
+		BenchArray2D();
+	TestIntroSort(bench);
+	TestParallelSort(bench);
+	TestListNodePool();
+	TestListFinger();
+	TestListSort();
+	TestListIterators();
+	TestSegmentedList(bench);
+	if (bench)
+		BenchArenaPages();
+	TestMemoryManagerThreads(bench);
+	TestAllocationProfiler(bench);
+	TestSizeClasses();
+	TestReallocInPlace();
+	TestSlabRelease(bench);
+	TestMemoryManager();
+	if (failures)
+		fprintf(stderr, "%d checks failed\n", failures);
+	else
+		printf("all checks passed\n");
+	return failures;
+}
+
+// =================================================================================================
@@ -105,7 +105,7 @@ void String::Log(const char* fmt, const char* s) {
 			SetBuffer(m_char, 2);
 		}
 		else { // capacity always > 2 here
-			Reserve(int32_t(capacity));
+			Resize(int32_t(capacity));
 			memcpy(Data(), source, m_length);
 			*Data(m_length) = '\0';
 			LOG("Creating string '%source'\n", Data());
@@ -133,7 +133,7 @@ void String::Log(const char* fmt, const char* s) {
 		char s[20];
 		snprintf(s, sizeof(s), "%d", n);
 		m_length = static_cast<int32_t>(strlen(s));
-		Reserve(m_length + 1);
+		Resize(m_length + 1);
 		memcpy(Data(), s, m_length + 1);
 	}
 
@@ -150,7 +150,7 @@ void String::Log(const char* fmt, const char* s) {
 		snprintf(s, sizeof(s), "%ld", n);
 #endif
 		m_length = static_cast<int32_t>(strlen(s));
-		Reserve(m_length + 1);
+		Resize(m_length + 1);
 		memcpy(Data(), s, m_length + 1);
 	}
 
@@ -236,7 +236,7 @@ void String::Log(const char* fmt, const char* s) {
 		for (auto const& v : values)
 			l += v.Length();
 		String result;
-		result.Reserve(l + 1);
+		result.Resize(l + 1);
 		char* p = result.Data();
 		for (auto const& v : values) {
 			l = v.Length();
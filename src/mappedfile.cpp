@@ -0,0 +1,162 @@
+#define NOMINMAX
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+// =================================================================================================
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* filename, Mode mode) {
+	Close();
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (not GetFileSizeEx(file, &fileSize) or (uint64_t(fileSize.QuadPart) > uint64_t(SIZE_MAX))) {
+		CloseHandle(file);
+		return false;
+	}
+	void* p = nullptr;
+	if (fileSize.QuadPart > 0) {
+		// a copy-on-write view is requested with PAGE_WRITECOPY on a file opened for reading only
+		HANDLE mapping = CreateFileMappingA(file, nullptr, (mode == Mode::CopyOnWrite) ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			p = MapViewOfFile(mapping, (mode == Mode::CopyOnWrite) ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping); // the view keeps the mapping alive
+		}
+		if (not p) {
+			CloseHandle(file);
+			return false;
+		}
+	}
+	CloseHandle(file);
+	m_address = p;
+	m_size = size_t(fileSize.QuadPart);
+	m_mode = mode;
+	m_isOpen = true;
+	return true;
+}
+
+
+void MappedFile::Close(void) {
+	if (m_address)
+		UnmapViewOfFile(m_address);
+	m_address = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+
+// Windows has no read ahead policies for mapped files; it can only be asked to read pages in
+bool MappedFile::Advise(Access access, size_t offset, size_t size) {
+	if (not m_address or (offset >= m_size))
+		return false;
+	if ((access != Access::WillNeed) and (access != Access::Sequential))
+		return true;
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = reinterpret_cast<char*>(m_address) + offset;
+	range.NumberOfBytes = (size and (size < m_size - offset)) ? size : m_size - offset;
+	return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0) != FALSE;
+}
+
+
+bool MappedFile::Write(const char* filename, const void* data, size_t size) {
+	HANDLE file = CreateFileA(filename, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	const char* p = reinterpret_cast<const char*>(data);
+	while (size) {
+		DWORD written;
+		DWORD chunk = DWORD((size < 0x40000000) ? size : 0x40000000);
+		if (not WriteFile(file, p, chunk, &written, nullptr) or not written) {
+			CloseHandle(file);
+			return false;
+		}
+		p += written;
+		size -= written;
+	}
+	return CloseHandle(file) != FALSE;
+}
+
+#else
+
+bool MappedFile::Open(const char* filename, Mode mode) {
+	Close();
+	int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) or not S_ISREG(info.st_mode)) {
+		close(fd);
+		return false;
+	}
+	void* p = nullptr;
+	if (info.st_size > 0) {
+		// private mappings of a file opened for reading can still be written to; the written pages
+		// are copied and never reach the file
+		int protection = (mode == Mode::CopyOnWrite) ? PROT_READ | PROT_WRITE : PROT_READ;
+		p = mmap(nullptr, size_t(info.st_size), protection, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+	}
+	close(fd); // the mapping keeps the file alive
+	m_address = p;
+	m_size = size_t(info.st_size);
+	m_mode = mode;
+	m_isOpen = true;
+	return true;
+}
+
+
+void MappedFile::Close(void) {
+	if (m_address)
+		munmap(m_address, m_size);
+	m_address = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+
+bool MappedFile::Advise(Access access, size_t offset, size_t size) {
+	if (not m_address or (offset >= m_size))
+		return false;
+	static const int advice[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED };
+	// madvise needs a page aligned start
+	uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+	uintptr_t end = uintptr_t(m_address) + ((size and (size < m_size - offset)) ? offset + size : m_size);
+	uintptr_t start = (uintptr_t(m_address) + offset) & ~(pageSize - 1);
+	return not madvise(reinterpret_cast<void*>(start), size_t(end - start), advice[int(access)]);
+}
+
+
+bool MappedFile::Write(const char* filename, const void* data, size_t size) {
+	int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+	const char* p = reinterpret_cast<const char*>(data);
+	while (size) {
+		ssize_t written = write(fd, p, size);
+		if (written <= 0) {
+			close(fd);
+			return false;
+		}
+		p += written;
+		size -= size_t(written);
+	}
+	return not close(fd);
+}
+
+#endif
+
+// =================================================================================================
@@ -3,178 +3,408 @@
 #include "allocator.h"
 
 #include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdlib>
 #include <new>
 
-typedef struct { int data; int key; } avlTestData;
-
-avlTestData avlTestSet[] = {
-#if 0
-	{ 0, 163371584 },
-	{ 1, 163442016 },
-	{ 2, 163538944 },
-	{ 3, 163377040 },
-	{ 4, 163565168 },
-	{ 5, 163566064 },
-	{ 6, 163567600 },
-	{ 7, 163565296 },
-	{ 8, 163567984 },
-	{ 9, 163566576 },
-	{ 10, 163567088 },
-	{ 11, 163564656 },
-	{ 12, 163567472 },
-	{ 13, 163564912 },
-	{ 14, 163567216 },
-	{ 15, 163568368 },
-	{ 16, 163568112 },
-	{ 17, 163568240 },
-	{ 18, 163565680 },
-	{ 19, 55054912 },
-	{ 20, 164165120 },
-	{ 21, 164169856 },
-	{ 22, 164165504 },
-	{ 23, 164168960 },
-	{ 24, 164171392 },
-	{ 25, 164255552 },
-	{ 26, 164169984 },
-	{ 27, 164171904 },
-	{ -27, 164171904 },
-	{ 27, 164253056 },
-	{ 28, 164165632 },
-	{ 29, 164171904 },
-	{ -29, 164171904 },
-	{ 29, 54986864 },
-	{ 30, 164165248 },
-	{ 31, 55020864 },
-	{ 32, 164180816 },
-	{ 33, 164170112 },
-	{ -32, 164180816 },
-	{ 32, 164222512 },
-	{ -33, 164170112 },
-	{ 33, 55020960 },
-	{ 34, 164083120 },
-	{ 35, 164170112 },
-	{ 36, 164170240 },
-	{ 37, 164170368 },
-	{ 38, 164171904 },
-	{ -37, 164170368 },
-	{ -38, 164171904 },
-	{ -34, 164083120 },
-	{ -33, 55020960 },
-	{ -35, 164170112 },
-	{ 36, 164170240 },
-	{ 36, 55020960 },
-	{ 35, 164180816 },
-	{ 33, 164177232 },
-	{ 34, 164170112 },
-	{ 38, 164177344 },
-	{ 37, 164171904 },
-	{ -38 , 164177344 },
-	{ -37 , 164171904 },
-	{ -35 , 164180816 },
-	{ -36 , 55020960 },
-	{ -33 , 164177232 },
-	{ -34 , 164170112 },
-	{ 34, 55020960 },
-	{ 33, 55106304 },
-	{ 36, 164168064 },
-	{ 35, 55105920 },
-	{ 37, 164165376 },
-	{ -35 , 55105920 } 
-#endif
-#if 1
-{ 0, 69820528 },
-{ 1, 264514104 },
-{ 2, 69820584 },
-{ 3, 264514048 },
-{ 4, 69820616 },
-{ 5, 264513992 },
-{ 6, 69820672 },
-{ 7, 264513936 },
-{ 8, 69820728 },
-{ 9, 264513880 },
-{ 10, 69820784 },
-{ 11, 264513824 },
-{ 12, 69820840 },
-{ 13, 264513768 },
-{ 14, 69820896 },
-{ 15, 264513712 },
-{ 16, 69820952 },
-{ 17, 264513656 },
-{ 18, 69821008 },
-{ 19, 264513056 },
-{ 20, 69821064 },
-{ 21, 264513000 },
-{ 22, 69821120 },
-{ 23, 264512944 },
-{ 24, 69821176 },
-{ 25, 264512808 },
-{ 26, 69821232 },
-{ 27, 264512752 },
-{ -27, 264512752 },
-{ 27, 69821288 },
-{ 28, 264512696 },
-{ 29, 69821424 },
-{ -29, 69821424 },
-{ 29, 264512584 },
-{ 30, 69821480 },
-{ 31, 264512552 },
-{ 32, 69821536 },
-{ 33, 264512488 },
-{ -32, 69821536 },
-{ 32, 69821584 },
-{ -33, 264512488 }
-#endif
-};
+// =================================================================================================
 
+// Destroy leaves the arena mapped, since static objects destroyed after the MemoryManager may
+// still release their blocks. Creating the manager again replaces the arena; blocks of the old
+// one still held by thread caches are discarded (see CurrentCache).
+bool MemoryManager::Create(int capacity, bool createOnce, const ArenaOptions& arenaOptions) {
+	if (createOnce and memoryPool and not m_isDestroyed)
+		return true;
+	m_isDestroyed = false;
+	++m_epoch;
+	if (not m_arena.Create(arenaOptions))
+		return false;
+	memoryPool = memoryStart = m_arena.GetAddress();
+	memoryEnd = memoryStart + m_arena.Size();
+	SetupSizeClasses();
+	m_regionCount = 0;
+	return m_regions.Create(capacity, createOnce) and m_externalBlocks.Create(std::max(capacity / 16, 256), createOnce);
+}
 
-// =================================================================================================
 
-bool MemoryManager::Create(int capacity, bool createOnce) {
-	memoryPool = memoryStart = reinterpret_cast<Address>(malloc(1000 * 1000 * 1000));
-	memoryEnd = memoryStart + 1000 * 1000 * 1000;
-	return m_memoryDescriptors.Create(capacity, KeyComparer, this, createOnce);
+void MemoryManager::SetupSizeClasses(void) {
+	for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+		SizeClass& sc = m_sizeClasses[i];
+		sc = SizeClass();
+		sc.blockSize = SizeClassSize(i);
+		sc.slabSize = std::max(MIN_SLAB_SIZE, 8 * sc.blockSize);
+		sc.batchSize = std::clamp(32768 / sc.blockSize, 2, 32);
+	}
+	m_largeBlocks = nullptr;
+	m_requestedBytes = 0;
+	m_reallocInPlace = 0;
+	m_reallocMoved = 0;
+	m_largeUsedBytes =
+	m_largeFreeBytes = 0;
+	m_largeUsedCount =
+	m_largeFreeCount = 0;
 }
 
 
-void MemoryManager::Destroy(void) {
-	m_memoryDescriptors.Destroy();
+// map a block size to the smallest size class holding it; -1 if it exceeds the largest class
+int MemoryManager::SizeClassIndex(uint32_t size) {
+	if (size <= 128)
+		return (size <= 16) ? 0 : int((size + 15) >> 4) - 1;
+	if (size > MAX_CLASS_SIZE)
+		return -1;
+	int log2 = int(std::bit_width(size - 1)) - 1; // size lies in (2^log2, 2^(log2 + 1)]
+	return 8 + (log2 - 7) * 4 + int(((size - 1) >> (log2 - 2)) & 3);
 }
 
 
-bool MemoryManager::IsIntact(MemoryDescriptor& md) {
-	return md.address and not strncmp(md.address - 11, "@#@#", 4) and not strncmp(md.address + md.size, "@#@#", 4);
+int32_t MemoryManager::SizeClassSize(int classIndex) {
+	if (classIndex < 8)
+		return (classIndex + 1) * 16;
+	int log2 = 7 + (classIndex - 8) / 4;
+	return (1 << log2) + ((classIndex - 8) % 4 + 1) * (1 << (log2 - 2));
 }
 
 
-bool MemoryManager::IsIntact(int itemIndex) {
-	return (itemIndex < 0) ? true : IsIntact(m_memoryDescriptors[itemIndex]);
+MemoryManager::Address MemoryManager::ClaimBlock(int classIndex) {
+	SizeClass& sc = m_sizeClasses[classIndex];
+	Address address = sc.freeBlocks;
+	if (address) {
+		sc.freeBlocks = BlockHeader::Link(address);
+		--sc.freeBlockCount;
+	}
+	else {
+		if (sc.slabCursor + sc.blockSize > sc.slabEnd) {
+			uint32_t regionSize = uint32_t(sc.slabSize);
+			Address slab = TakeFreeMemory(regionSize);
+			if (not slab)
+				return nullptr;
+			if (not ClaimRegion(slab, int32_t(regionSize), classIndex, sc.slabDescriptor)) {
+				ReleaseLargeBlock(slab, regionSize);
+				return nullptr;
+			}
+			sc.slabCursor = slab;
+			sc.slabEnd = slab + sc.slabSize;
+			++sc.slabCount;
+		}
+		// the header is set up once when the block is carved and stays with the block
+		address = sc.slabCursor;
+		sc.slabCursor += sc.blockSize;
+		m_regions[sc.slabDescriptor].size += sc.blockSize;
+		BlockHeader* header = reinterpret_cast<BlockHeader*>(address);
+		header->descriptorIndex = sc.slabDescriptor;
+		header->size = 0;
+		header->sizeClass = int16_t(classIndex);
+		header->flags = 0;
+		memcpy(header->guard, BLOCK_GUARD, GUARD_SIZE);
+	}
+	++m_regions[int(reinterpret_cast<BlockHeader*>(address)->descriptorIndex)].liveCount;
+	++sc.usedBlockCount;
+	return address;
 }
 
 
+void MemoryManager::ReleaseBlock(Address address, int classIndex) {
+	SizeClass& sc = m_sizeClasses[classIndex];
+	BlockHeader::Link(address) = sc.freeBlocks;
+	sc.freeBlocks = address;
+	--sc.usedBlockCount;
+	++sc.freeBlockCount;
+	uint32_t descriptorIndex = reinterpret_cast<BlockHeader*>(address)->descriptorIndex;
+	MemoryDescriptor& md = m_regions[int(descriptorIndex)];
+	if (not --md.liveCount and (descriptorIndex != sc.slabDescriptor) and (sc.freeBlockCount - md.size / sc.blockSize >= sc.slabSize / sc.blockSize))
+		ReleaseSlab(classIndex, descriptorIndex);
+}
 
-bool MemoryManager::IsAddress(int itemIndex) {
-	if (ToKey(m_memoryDescriptors[itemIndex].address) == m_key)
-		return true;
-	return false;
+
+// take the blocks of an unused slab off its class's free list and return the slab to the arena.
+// m_lock must be held
+void MemoryManager::ReleaseSlab(int classIndex, uint32_t descriptorIndex) {
+	SizeClass& sc = m_sizeClasses[classIndex];
+	MemoryDescriptor& md = m_regions[int(descriptorIndex)];
+	Address start = md.address;
+	Address end = start + md.size;
+	for (Address* link = &sc.freeBlocks; *link; ) {
+		if ((*link >= start) and (*link < end)) {
+			*link = BlockHeader::Link(*link);
+			--sc.freeBlockCount;
+		}
+		else
+			link = &BlockHeader::Link(*link);
+	}
+	--sc.slabCount;
+	ReleaseLargeBlock(start, size_t(md.blockSize));
+	ReleaseRegion(descriptorIndex);
 }
 
 
-bool MemoryManager::ItemProcessor(void* context, const Key& key, const int& itemIndex) {
-	return context ? static_cast<MemoryManager*>(context)->IsIntact(itemIndex) : false;
+thread_local ThreadCache MemoryManager::m_threadCache;
+
+thread_local bool ThreadCache::m_isAlive = true;
+
+
+ThreadCache::~ThreadCache() {
+	MemoryManager::Instance().FlushCache(*this);
+	m_isAlive = false;
+}
+
+
+// claim a batch of blocks from the size class for the thread cache and return one of them
+// m_lock must be held
+MemoryManager::Address MemoryManager::FillCache(ThreadCache& cache, int classIndex) {
+	Address address = ClaimBlock(classIndex);
+	if (address) {
+		for (int32_t i = m_sizeClasses[classIndex].batchSize - 1; i > 0; i--) {
+			Address block = ClaimBlock(classIndex);
+			if (not block)
+				break;
+			cache.Push(block, classIndex);
+		}
+	}
+	return address;
 }
 
 
-bool MemoryManager::ItemFinder(void* context, const Key& key, const int& itemIndex) {
-	return context ? static_cast<MemoryManager*>(context)->IsAddress(itemIndex) : false;
+// m_lock must be held
+void MemoryManager::DrainCache(ThreadCache& cache, int classIndex, int32_t count) {
+	for (; count; count--) {
+		Address address = cache.Pop(classIndex);
+		if (not address)
+			break;
+		ReleaseBlock(address, classIndex);
+	}
+}
+
+
+void MemoryManager::FlushCache(ThreadCache& cache) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_isDestroyed or (cache.m_epoch != m_epoch)) {
+		cache.Discard();
+		return;
+	}
+	for (int i = 0; i < SIZE_CLASS_COUNT; i++)
+		DrainCache(cache, i, cache.m_classCaches[i].count);
+}
+
+
+// first fit search of the released large blocks and slabs; carve new memory from the arena if none
+// fits. blockSize is updated to the size of the memory actually handed out.
+MemoryManager::Address MemoryManager::TakeFreeMemory(uint32_t& blockSize) {
+	blockSize = (blockSize + 15) & ~15u;
+	for (FreeBlock* fb = m_largeBlocks; fb; fb = fb->next) {
+		if (fb->size < blockSize)
+			continue;
+		size_t remainder = fb->size - blockSize;
+		UnlinkLargeBlock(fb);
+		if (remainder > MAX_CLASS_SIZE)
+			ReleaseLargeBlock(reinterpret_cast<Address>(fb) + blockSize, remainder);
+		else
+			blockSize = uint32_t(fb->size);
+		return reinterpret_cast<Address>(fb);
+	}
+	return Reserve(blockSize);
+}
+
+
+MemoryManager::Address MemoryManager::ClaimLargeBlock(uint32_t& blockSize) {
+	Address address = TakeFreeMemory(blockSize);
+	if (address) {
+		++m_largeUsedCount;
+		m_largeUsedBytes += blockSize;
+	}
+	return address;
+}
+
+
+void MemoryManager::UnlinkLargeBlock(FreeBlock* fb) {
+	if (fb->prev)
+		fb->prev->next = fb->next;
+	else
+		m_largeBlocks = fb->next;
+	if (fb->next)
+		fb->next->prev = fb->prev;
+	--m_largeFreeCount;
+	m_largeFreeBytes -= fb->size;
+}
+
+
+// The large block list is kept in address order so that released blocks can be merged with
+// adjacent free blocks. A free block ending at the arena tail is handed back to Reserve.
+// The commit chunks lying completely within the free block are decommitted.
+void MemoryManager::ReleaseLargeBlock(Address address, size_t blockSize) {
+	FreeBlock* prev = nullptr;
+	FreeBlock* next = m_largeBlocks;
+	for (; next and (reinterpret_cast<Address>(next) < address); next = next->next)
+		prev = next;
+	FreeBlock* fb = reinterpret_cast<FreeBlock*>(address);
+	if (prev and (reinterpret_cast<Address>(prev) + prev->size == address)) {
+		UnlinkLargeBlock(prev);
+		blockSize += prev->size;
+		fb = prev;
+		prev = fb->prev;
+	}
+	if (next and (reinterpret_cast<Address>(fb) + blockSize == reinterpret_cast<Address>(next))) {
+		UnlinkLargeBlock(next);
+		blockSize += next->size;
+		next = next->next;
+	}
+	if (reinterpret_cast<Address>(fb) + blockSize == memoryStart) {
+		memoryStart = reinterpret_cast<Address>(fb);
+		m_arena.Decommit(memoryStart, memoryStart + blockSize);
+		return;
+	}
+	m_arena.Decommit(reinterpret_cast<Address>(fb + 1), reinterpret_cast<Address>(fb) + blockSize);
+	fb->size = blockSize;
+	fb->prev = prev;
+	fb->next = next;
+	if (prev)
+		prev->next = fb;
+	else
+		m_largeBlocks = fb;
+	if (next)
+		next->prev = fb;
+	++m_largeFreeCount;
+	m_largeFreeBytes += blockSize;
+}
+
+
+// claim the descriptor of an arena region. m_lock must be held
+MemoryDescriptor* MemoryManager::ClaimRegion(Address address, int32_t regionSize, int classIndex, uint32_t& descriptorIndex) {
+	int itemIndex;
+	MemoryDescriptor* md = m_regions.Claim(itemIndex);
+	if (not md) {
+		fprintf(stderr, "%s (%d): out of memory descriptors\n", __FILE__, __LINE__);
+		return nullptr;
+	}
+	md->address = address;
+	md->size = 0;
+	md->blockSize = regionSize;
+	md->sizeClass = int16_t(classIndex);
+	md->isManaged = true;
+	md->liveCount = 0;
+	descriptorIndex = uint32_t(itemIndex);
+	if (itemIndex >= m_regionCount)
+		m_regionCount = itemIndex + 1;
+	return md;
+}
+
+
+// m_lock must be held
+void MemoryManager::ReleaseRegion(uint32_t descriptorIndex) {
+	MemoryDescriptor& md = m_regions[int(descriptorIndex)];
+	md.address = nullptr;
+	md.size = 0;
+	md.blockSize = 0;
+	md.sizeClass = -1;
+	m_regions.Release(int(descriptorIndex));
+}
+
+
+void MemoryManager::GetStatistics(MemoryStatistics& stats) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	stats = MemoryStatistics();
+	stats.arenaSize = size_t(memoryEnd - memoryPool);
+	stats.committedHighWater = m_arena.CommittedHighWater();
+	stats.reservedBytes = size_t(memoryStart - memoryPool);
+	stats.requestedBytes = m_requestedBytes;
+	for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+		SizeClass& sc = m_sizeClasses[i];
+		stats.classUsedBytes += size_t(sc.usedBlockCount) * sc.blockSize;
+		stats.classFreeBytes += size_t(sc.freeBlockCount) * sc.blockSize;
+	}
+	stats.largeUsedBytes = m_largeUsedBytes;
+	stats.largeFreeBytes = m_largeFreeBytes;
+	stats.largeUsedCount = m_largeUsedCount;
+	stats.largeFreeCount = m_largeFreeCount;
+	stats.reallocInPlace = m_reallocInPlace;
+	stats.reallocMoved = m_reallocMoved;
+	stats.fragmentation = stats.reservedBytes ? 1.0f - float(stats.requestedBytes) / float(stats.reservedBytes) : 0.0f;
+}
+
+
+void MemoryManager::PrintStatistics(FILE* stream) {
+	MemoryStatistics stats;
+	GetStatistics(stats);
+	fprintf(stream, "arena: %zu bytes reserved of %zu, %zu bytes requested, fragmentation %.1f%%\n",
+			stats.reservedBytes, stats.arenaSize, stats.requestedBytes, 100.0f * stats.fragmentation);
+	fprintf(stream, "arena backing: %s, page size %zu, NUMA node %d, up to %zu bytes committed\n",
+			m_arena.BackingName(), m_arena.m_pageSize, m_arena.m_numaNode, stats.committedHighWater);
+	fprintf(stream, "large blocks: %d used (%zu bytes), %d free (%zu bytes)\n",
+			stats.largeUsedCount, stats.largeUsedBytes, stats.largeFreeCount, stats.largeFreeBytes);
+	fprintf(stream, "reallocations: %zu in place, %zu moved\n", stats.reallocInPlace, stats.reallocMoved);
+	fprintf(stream, "class  block size  slabs  used blocks  free blocks  occupancy\n");
+	for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+		SizeClass& sc = m_sizeClasses[i];
+		if (not sc.slabCount)
+			continue;
+		int32_t carved = sc.usedBlockCount + sc.freeBlockCount;
+		// blocks held in thread caches count as used here
+		fprintf(stream, "%5d  %10d  %5d  %11d  %11d  %8.1f%%\n",
+				i, sc.blockSize, sc.slabCount, sc.usedBlockCount, sc.freeBlockCount, carved ? 100.0f * float(sc.usedBlockCount) / float(carved) : 0.0f);
+	}
 }
 
 
+// Blocks freed after this, e.g. by static objects destroyed later, are left in the arena; blocks
+// claimed after it fail, and so do reallocations that need a new block.
+void MemoryManager::Destroy(void) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_isDestroyed = true;
+	m_regions.Destroy();
+	m_externalBlocks.Destroy();
+	m_regionCount = 0;
+}
+
+
+// check the header of a block and, if it is handed out, the guard following its data
+bool MemoryManager::IsIntact(BlockHeader* header) {
+	return header->IsIntact() and (not header->IsLive() or not memcmp(header->Data() + header->size, BLOCK_GUARD, GUARD_SIZE));
+}
+
+
+// check all blocks carved from a region. m_lock must be held
+bool MemoryManager::IsIntact(int32_t descriptorIndex) {
+	MemoryDescriptor& md = m_regions[descriptorIndex];
+	if (not md.address)
+		return true;
+	if (md.sizeClass < 0)
+		return IsIntact(reinterpret_cast<BlockHeader*>(md.address));
+	int32_t blockSize = m_sizeClasses[md.sizeClass].blockSize;
+	for (Address block = md.address; block < md.address + md.size; block += blockSize) {
+		BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+		if (not IsIntact(header) or (header->descriptorIndex != uint32_t(descriptorIndex)))
+			return false;
+	}
+	return true;
+}
+
+
+// m_lock must be held
+bool MemoryManager::CheckRegions(int32_t first, int32_t count) {
+	bool isIntact = true;
+	for (int32_t i = first; i < first + count; i++) {
+		if (not IsIntact(i)) {
+			fprintf(stderr, "%s (%d): memory region #%d is corrupted\n", __FILE__, __LINE__, i);
+			isIntact = false;
+		}
+	}
+	return isIntact;
+}
+
+
+// sweep all regions
 bool MemoryManager::CheckIntegrity(void) {
-//	for (int i = 0; (md = m_memoryDescriptors.UsedItem(i)); i++) {
-	return m_memoryDescriptors.UsedItems().Walk(ItemProcessor, this);
-	///return m_memoryDescriptors.ProcessItems(this->IsIntact);
+	std::lock_guard<std::mutex> lock(m_lock);
+	return CheckRegions(0, m_regionCount);
+}
+
+
+// sweep sweepSize regions every interval locked operations; interval 0 turns sampled sweeps off
+void MemoryManager::SetIntegrityChecks(int32_t interval, int32_t sweepSize) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_sweepInterval = std::max(interval, 0);
+	m_sweepSize = std::max(sweepSize, 1);
+	m_sweepCountdown = m_sweepInterval;
 }
 
 
@@ -183,8 +413,11 @@ MemoryManager::Address MemoryManager::Reserve(uint32_t size) {
 		return nullptr;
 	allocFromStart = true; // !allocFromStart;
 	if (allocFromStart) {
+		if (not m_arena.Commit(memoryStart + size))
+			return nullptr;
 		Address p = memoryStart;
 		memoryStart += size;
+		m_arena.Place(p, size);
 		return p;
 	}
 	else {
@@ -194,55 +427,68 @@ MemoryManager::Address MemoryManager::Reserve(uint32_t size) {
 }
 
 
-MemoryDescriptor* MemoryManager::Claim(uint32_t size) {
-	CheckIntegrity();
-	Address address = Reserve(size + 16); // static_cast<Address>(malloc(size + 16));
-	if (not address) {
-		//fprintf(stderr, "%s (%d): memory allocation failed\n", __FILE__, __LINE__);
+// Fails after Destroy: the descriptors new blocks are registered in are gone.
+MemoryManager::Address MemoryManager::Claim(uint32_t size, void* caller) {
+	// the block size, header and guard included, has to fit 32 bits
+	if (m_isDestroyed or (size > UINT32_MAX - sizeof(BlockHeader) - GUARD_SIZE))
 		return nullptr;
-	}
-#define AVL_TEST 0
-#if AVL_TEST
-	for (int i = 0; i < sizeof(avlTestSet) / sizeof(*avlTestSet); i++) {
-		avlTestData& h = avlTestSet[i];
-		int data, key = abs(h.key);
-		if (h.key < 0) {
-			m_memoryDescriptors.UsedItems().Extract(h.key, data);
-			if (m_memoryDescriptors.UsedItems().FindData(h.data))
-				fprintf(stderr, "                                                duplicate item index #%d\n", h.data);
+	uint32_t blockSize = size + sizeof(BlockHeader) + GUARD_SIZE;
+	int sizeClass = SizeClassIndex(blockSize);
+	// once the thread cache has been flushed at thread exit, blocks must not go back into it
+	bool useCache = (sizeClass >= 0) and ThreadCache::m_isAlive;
+	Address block = useCache ? CurrentCache().Pop(sizeClass) : nullptr;
+	if (not block) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		SampleIntegrity();
+		if (useCache)
+			block = FillCache(m_threadCache, sizeClass);
+		else if (sizeClass >= 0)
+			block = ClaimBlock(sizeClass);
+		else if ((block = ClaimLargeBlock(blockSize))) {
+			uint32_t descriptorIndex;
+			MemoryDescriptor* md = ClaimRegion(block, int32_t(blockSize), -1, descriptorIndex);
+			if (not md) {
+				--m_largeUsedCount;
+				m_largeUsedBytes -= blockSize;
+				ReleaseLargeBlock(block, blockSize);
+				return nullptr;
+			}
+			md->size = int32_t(size);
+			BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+			header->descriptorIndex = descriptorIndex;
+			header->sizeClass = -1;
+			memcpy(header->guard, BLOCK_GUARD, GUARD_SIZE);
+		}
+		if (not block) {
+			//fprintf(stderr, "%s (%d): memory allocation failed\n", __FILE__, __LINE__);
+			return nullptr;
 		}
-		else
-			m_memoryDescriptors.UsedItems().Insert(h.key, h.data);
 	}
+	BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+	Address address = header->Data();
+#ifdef _DEBUG
+	memset(address, ' ', size);
 #endif
-	Key key = ToKey(address);
-	MemoryDescriptor* md = m_memoryDescriptors.Claim(key); // address);
-	if (not md) {
-		//free(address);
-		//fprintf(stderr, "MM::Alloc: out of memory blocks\n");
-		return nullptr;
+	memcpy(address + size, BLOCK_GUARD, GUARD_SIZE);
+	header->size = size;
+	header->flags = BlockHeader::isLive;
+	m_requestedBytes += size;
+	if (m_profiler.Sample()) {
+		header->flags |= BlockHeader::isSampled;
+		m_profiler.RecordAlloc(address, size, caller);
 	}
-	md->address = address;
-	md->size = size;
-	memcpy(md->address, "@#@#", 4);
-	md->address += 4;
-	sprintf(md->address, "%06d", int(md - GetDataPool()));
-	md->address += 7;
-	memset(md->address, ' ', size);
-	memcpy(md->address + size, "@#@#", 5);
-	md->isManaged = true;
-	//fprintf(stderr, "MM::Alloc: %zd bytes\n", size);
-	fprintf(stderr, "Allocating memory buffer '%lld'\n", key);
-	return md;
+	return address;
 }
 
 
-void* MemoryManager::Alloc(uint32_t size) {
-	MemoryDescriptor* md = Claim(size);
-	return md ? reinterpret_cast<void*>(md->address) : nullptr;
+void* MemoryManager::Alloc(uint32_t size, void* caller) {
+	return reinterpret_cast<void*>(Claim(size, caller ? caller : CALLER_ADDRESS()));
 }
 
 
+// Size class blocks are kept if the new size still fits and uses at least half of the block.
+// Large blocks grow into the arena tail or a free block following them and shrink by splitting
+// off the remainder. Only if that is not possible, the data is moved to a new block.
 void* MemoryManager::Realloc(void* address, uint32_t size, bool bCopy) {
 	if (not address) {
 		//fprintf(stderr, "%s (%d): realloc on nullptr\n", __FILE__, __LINE__);
@@ -254,84 +500,192 @@ void* MemoryManager::Realloc(void* address, uint32_t size, bool bCopy) {
 		return nullptr;
 	}
 
-	MemoryDescriptor* mbNew = Claim(size);
-	if (not mbNew)
+	if (not IsArenaAddress(address)) {
+		fprintf(stderr, "%s (%d): cannot reallocate unmanaged memory\n", __FILE__, __LINE__);
 		return address;
+	}
+	BlockHeader* header = BlockHeader::Of(address);
+	if (not (IsIntact(header) and header->IsLive())) {
+		fprintf(stderr, "%s (%d): memory buffer is corrupted\n", __FILE__, __LINE__);
+		return address;
+	}
 
-	address = Address (address) - 11;
-	Key key = ToKey(address);
-	MemoryDescriptor* mbOld = m_memoryDescriptors.FindItem(key);
-	if (not mbOld) {
-		fprintf(stderr, "%s (%d): memory block list is corrupted\n", __FILE__, __LINE__);
-		mbOld = m_memoryDescriptors.FindItem(key);
+	// like a failed move, a size whose block does not fit 32 bits leaves the block as it is
+	if (size > UINT32_MAX - sizeof(BlockHeader) - GUARD_SIZE)
 		return address;
+	uint32_t oldSize = header->size;
+	uint32_t blockSize = size + sizeof(BlockHeader) + GUARD_SIZE;
+	bool inPlace;
+	if (header->sizeClass >= 0) {
+		uint32_t classSize = uint32_t(m_sizeClasses[header->sizeClass].blockSize);
+		inPlace = (blockSize <= classSize) and (2 * blockSize > classSize);
 	}
-	if (mbOld->isManaged) {
-		fprintf(stderr, "%s (%d): cannot reallocate unmanaged memory\n", __FILE__, __LINE__);
+	else // blocks small enough for a size class move there
+		inPlace = (blockSize > MAX_CLASS_SIZE) and ResizeLargeBlock(header, size);
+	if (inPlace) {
+#ifdef _DEBUG
+		if (size > oldSize)
+			memset(Address(address) + oldSize, ' ', size - oldSize);
+#endif
+		memcpy(Address(address) + size, BLOCK_GUARD, GUARD_SIZE);
+		header->size = size;
+		m_requestedBytes += size;
+		m_requestedBytes -= oldSize;
+		if (header->flags & BlockHeader::isSampled) {
+			m_profiler.RecordFree(address);
+			m_profiler.RecordAlloc(address, size, CALLER_ADDRESS());
+		}
+		++m_reallocInPlace;
 		return address;
 	}
 
+	void* newAddress = Claim(size, CALLER_ADDRESS());
+	if (not newAddress)
+		return address;
 	if (bCopy)
-		memcpy(mbNew->address, address, std::min(uint32_t(mbNew->size), uint32_t(mbOld->size)));
-	//fprintf(stderr, "MM::Realloc: releasing %zd bytes @ %p\n", md->size, md->address);
-	try {
-		free(address);
+		memcpy(newAddress, address, std::min(size, oldSize));
+	Free(address);
+	++m_reallocMoved;
+	return newAddress;
+}
+
+
+// resize a large block to hold size bytes without moving it; returns false if that is not possible
+bool MemoryManager::ResizeLargeBlock(BlockHeader* header, uint32_t size) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_isDestroyed)
+		return false;
+	SampleIntegrity();
+	Address block = reinterpret_cast<Address>(header);
+	MemoryDescriptor& md = m_regions[int(header->descriptorIndex)];
+	size_t blockSize = size_t(md.blockSize);
+	size_t newSize = (size_t(size) + sizeof(BlockHeader) + GUARD_SIZE + 15) & ~size_t(15);
+	Address blockEnd = block + blockSize;
+	if (newSize > blockSize) {
+		size_t growth = newSize - blockSize;
+		if (blockEnd == memoryStart) {
+			if (not Reserve(uint32_t(growth)))
+				return false;
+		}
+		else {
+			FreeBlock* fb = m_largeBlocks;
+			while (fb and (reinterpret_cast<Address>(fb) < blockEnd))
+				fb = fb->next;
+			if (not fb or (reinterpret_cast<Address>(fb) != blockEnd) or (fb->size < growth))
+				return false;
+			size_t remainder = fb->size - growth;
+			UnlinkLargeBlock(fb);
+			if (remainder > MAX_CLASS_SIZE)
+				ReleaseLargeBlock(blockEnd + growth, remainder);
+			else
+				newSize += remainder;
+		}
 	}
-	catch (...) {
-		fprintf(stderr, "MM: low level memory corruption encountered\n");
+	else {
+		size_t remainder = blockSize - newSize;
+		// the arena tail takes back any remainder; elsewhere it must be able to serve another large block
+		if ((remainder > MAX_CLASS_SIZE) or (remainder and (blockEnd == memoryStart)))
+			ReleaseLargeBlock(block + newSize, remainder);
+		else
+			newSize = blockSize;
 	}
-	mbOld->address = nullptr;
-	mbOld->size = 0;
-	m_memoryDescriptors.Release(key);
-	return mbNew->address;
+	m_largeUsedBytes += newSize;
+	m_largeUsedBytes -= blockSize;
+	md.blockSize = int32_t(newSize);
+	md.size = int32_t(size);
+	return true;
 }
 
 
-void MemoryManager::Free(void* address) {
-	address = reinterpret_cast<Address>(address) - 11;
-	Key key = ToKey(address);
-	//Address key = reinterpret_cast<Address>(address) - 11;
-	fprintf(stderr, "                                                Freeing memory buffer '%zd'\n", key);
-	MemoryDescriptor* md = m_memoryDescriptors.Release(key);
-	if (not md) {
+// return a large block to the arena
+void MemoryManager::ReleaseLarge(BlockHeader* header) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	SampleIntegrity();
+	Address block = reinterpret_cast<Address>(header);
+	uint32_t descriptorIndex = header->descriptorIndex;
+	MemoryDescriptor* md = (descriptorIndex < uint32_t(m_regionCount)) ? &m_regions[int(descriptorIndex)] : nullptr;
+	if (not md or (md->address != block) or (md->sizeClass >= 0)) {
 		fprintf(stderr, "%s (%d): memory block list is corrupted\n", __FILE__, __LINE__);
-		m_key = key;
-		m_memoryDescriptors.UsedItems().Walk(ItemFinder, this);
 		return;
 	}
+	--m_largeUsedCount;
+	m_largeUsedBytes -= md->blockSize;
+	ReleaseLargeBlock(block, size_t(md->blockSize)); // overwrites the header
+	ReleaseRegion(descriptorIndex);
+}
+
 
-	if (not IsIntact(*md)) {
+// forget a buffer registered with SetPtr; the buffer itself belongs to the caller
+void MemoryManager::ReleaseExternal(void* address) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (not m_externalBlocks.Release(Key(address)))
+		fprintf(stderr, "%s (%d): freeing unknown memory buffer\n", __FILE__, __LINE__);
+}
+
+
+void MemoryManager::Free(void* address) {
+	if (not address or m_isDestroyed)
+		return;
+	if (not IsArenaAddress(address)) {
+		ReleaseExternal(address);
+		return;
+	}
+	BlockHeader* header = BlockHeader::Of(address);
+	if (not IsIntact(header)) {
 		fprintf(stderr, "%s (%d): memory buffer is corrupted\n", __FILE__, __LINE__);
-		address = address;
+		return;
 	}
-#if 0
-	if (md->isManaged) {
-		try {
-			free(address);
-		}
-		catch (...) {
-			fprintf(stderr, "MM: low level memory corruption encountered\n");
-		}
+	if (not header->IsLive()) {
+		fprintf(stderr, "%s (%d): memory buffer released twice\n", __FILE__, __LINE__);
+		return;
+	}
+	if (header->flags & BlockHeader::isSampled)
+		m_profiler.RecordFree(address);
+	header->flags = 0;
+	m_requestedBytes -= header->size;
+	int sizeClass = header->sizeClass;
+	Address block = reinterpret_cast<Address>(header);
+	if (sizeClass < 0)
+		ReleaseLarge(header);
+	else if (not ThreadCache::m_isAlive) { // thread is exiting
+		std::lock_guard<std::mutex> lock(m_lock);
+		ReleaseBlock(block, sizeClass);
+	}
+	else if (CurrentCache().Push(block, sizeClass) > 2 * m_sizeClasses[sizeClass].batchSize) {
+		std::lock_guard<std::mutex> lock(m_lock);
+		SampleIntegrity();
+		DrainCache(m_threadCache, sizeClass, m_sizeClasses[sizeClass].batchSize);
 	}
-#endif
-	md->address = nullptr;
-	md->size = 0;
-	md->isManaged = true;
-	CheckIntegrity();
 }
 
 
+// register a buffer not allocated by the MemoryManager, so that Free accepts it
 void* MemoryManager::SetPtr(void* address, uint32_t size) {
-	Key key = ToKey(address);
-	MemoryDescriptor* md = m_memoryDescriptors.Claim(key);
+	std::lock_guard<std::mutex> lock(m_lock);
+	Key key = Key(address);
+	MemoryDescriptor* md = m_externalBlocks.Claim(key);
 	if (not md) {
 		//fprintf(stderr, "MM::SetPtr: out of memory blocks\n");
 		return nullptr;
 	}
 	md->address = static_cast<Address>(address);
 	md->size = size;
+	md->blockSize = 0;
+	md->sizeClass = -1;
 	md->isManaged = false;
 	return address;
 }
 
+
+bool MemoryManager::StartProfiler(int32_t sampleInterval, const char* reportPath) {
+	if (not m_profiler.Create(sampleInterval))
+		return false;
+	return not reportPath or m_profiler.InstallSignalHandler(reportPath);
+}
+
+
+void MemoryManager::StopProfiler(void) {
+	m_profiler.Destroy();
+}
+
 // =================================================================================================
@@ -0,0 +1,884 @@
+#define NOMINMAX
+
+#include "simdkernels.h"
+
+#include <atomic>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#	define SIMD_X86 1
+#	include <immintrin.h>
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#		define SSE2_TARGET
+#		define AVX2_TARGET
+#	else
+#		define SSE2_TARGET	__attribute__((target("sse2")))
+#		define AVX2_TARGET	__attribute__((target("avx2")))
+#	endif
+#else
+#	define SIMD_X86 0
+#endif
+
+// =================================================================================================
+
+class KernelTable {
+public:
+	void		(*fill32)(uint32_t* data, int32_t count, uint32_t value);
+	int32_t		(*findFloat)(const float* data, int32_t count, float value);
+	int32_t		(*findInt)(const int32_t* data, int32_t count, int32_t value);
+	int32_t		(*findByte)(const uint8_t* data, int32_t count, uint8_t value);
+	int32_t		(*countFloat)(const float* data, int32_t count, float value);
+	int32_t		(*countInt)(const int32_t* data, int32_t count, int32_t value);
+	int32_t		(*countByte)(const uint8_t* data, int32_t count, uint8_t value);
+	float		(*minFloat)(const float* data, int32_t count);
+	int32_t		(*minInt)(const int32_t* data, int32_t count);
+	uint8_t		(*minByte)(const uint8_t* data, int32_t count);
+	float		(*maxFloat)(const float* data, int32_t count);
+	int32_t		(*maxInt)(const int32_t* data, int32_t count);
+	uint8_t		(*maxByte)(const uint8_t* data, int32_t count);
+	float		(*sumFloat)(const float* data, int32_t count);
+	int64_t		(*sumInt)(const int32_t* data, int32_t count);
+	uint64_t	(*sumByte)(const uint8_t* data, int32_t count);
+	void		(*addFloat)(float* dest, const float* source, int32_t count);
+	void		(*addInt)(int32_t* dest, const int32_t* source, int32_t count);
+	void		(*mulFloat)(float* dest, const float* source, int32_t count);
+	void		(*mulInt)(int32_t* dest, const int32_t* source, int32_t count);
+	bool		(*equal)(const uint8_t* a, const uint8_t* b, size_t size);
+};
+
+// =================================================================================================
+// scalar kernels; the vector kernels use them for the elements behind the last full vector
+
+template <typename T>
+static void FillScalar(T* data, int32_t count, T value) {
+	for (int32_t i = 0; i < count; i++)
+		data[i] = value;
+}
+
+
+template <typename T>
+static int32_t FindScalar(const T* data, int32_t count, T value) {
+	for (int32_t i = 0; i < count; i++)
+		if (data[i] == value)
+			return i;
+	return -1;
+}
+
+
+template <typename T>
+static int32_t CountScalar(const T* data, int32_t count, T value) {
+	int32_t n = 0;
+	for (int32_t i = 0; i < count; i++)
+		n += (data[i] == value);
+	return n;
+}
+
+
+template <typename T>
+static T MinScalar(const T* data, int32_t count) {
+	T m = data[0];
+	for (int32_t i = 1; i < count; i++)
+		if (data[i] < m)
+			m = data[i];
+	return m;
+}
+
+
+template <typename T>
+static T MaxScalar(const T* data, int32_t count) {
+	T m = data[0];
+	for (int32_t i = 1; i < count; i++)
+		if (data[i] > m)
+			m = data[i];
+	return m;
+}
+
+
+template <typename S, typename T>
+static S SumScalar(const T* data, int32_t count) {
+	S sum = 0;
+	for (int32_t i = 0; i < count; i++)
+		sum += data[i];
+	return sum;
+}
+
+
+// integers wrap around like the vector instructions do
+template <typename T>
+static void AddScalar(T* dest, const T* source, int32_t count) {
+	for (int32_t i = 0; i < count; i++)
+		if constexpr (std::is_integral_v<T>)
+			dest[i] = T(uint32_t(dest[i]) + uint32_t(source[i]));
+		else
+			dest[i] += source[i];
+}
+
+
+template <typename T>
+static void MulScalar(T* dest, const T* source, int32_t count) {
+	for (int32_t i = 0; i < count; i++)
+		if constexpr (std::is_integral_v<T>)
+			dest[i] = T(uint32_t(dest[i]) * uint32_t(source[i]));
+		else
+			dest[i] *= source[i];
+}
+
+
+static bool EqualScalar(const uint8_t* a, const uint8_t* b, size_t size) {
+	return (size == 0) or (memcmp(a, b, size) == 0);
+}
+
+
+static const KernelTable scalarKernels = {
+	FillScalar<uint32_t>,
+	FindScalar<float>, FindScalar<int32_t>, FindScalar<uint8_t>,
+	CountScalar<float>, CountScalar<int32_t>, CountScalar<uint8_t>,
+	MinScalar<float>, MinScalar<int32_t>, MinScalar<uint8_t>,
+	MaxScalar<float>, MaxScalar<int32_t>, MaxScalar<uint8_t>,
+	SumScalar<float, float>, SumScalar<int64_t, int32_t>, SumScalar<uint64_t, uint8_t>,
+	AddScalar<float>, AddScalar<int32_t>,
+	MulScalar<float>, MulScalar<int32_t>,
+	EqualScalar
+};
+
+#if SIMD_X86
+
+// =================================================================================================
+// SSE2 kernels; 4 floats or integers or 16 bytes per step
+
+SSE2_TARGET static void Fill32Sse2(uint32_t* data, int32_t count, uint32_t value) {
+	__m128i v = _mm_set1_epi32(int(value));
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), v);
+	FillScalar(data + i, count - i, value);
+}
+
+
+SSE2_TARGET static int32_t FindFloatSse2(const float* data, int32_t count, float value) {
+	__m128 v = _mm_set1_ps(value);
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		uint32_t mask = uint32_t(_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), v)));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+	int32_t j = FindScalar(data + i, count - i, value);
+	return (j < 0) ? -1 : i + j;
+}
+
+
+SSE2_TARGET static int32_t FindIntSse2(const int32_t* data, int32_t count, int32_t value) {
+	__m128i v = _mm_set1_epi32(value);
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i e = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), v);
+		uint32_t mask = uint32_t(_mm_movemask_ps(_mm_castsi128_ps(e)));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+	int32_t j = FindScalar(data + i, count - i, value);
+	return (j < 0) ? -1 : i + j;
+}
+
+
+SSE2_TARGET static int32_t FindByteSse2(const uint8_t* data, int32_t count, uint8_t value) {
+	__m128i v = _mm_set1_epi8(char(value));
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i e = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), v);
+		uint32_t mask = uint32_t(_mm_movemask_epi8(e));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+	int32_t j = FindScalar(data + i, count - i, value);
+	return (j < 0) ? -1 : i + j;
+}
+
+
+SSE2_TARGET static int32_t CountFloatSse2(const float* data, int32_t count, float value) {
+	__m128 v = _mm_set1_ps(value);
+	int32_t n = 0;
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		n += std::popcount(uint32_t(_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), v))));
+	return n + CountScalar(data + i, count - i, value);
+}
+
+
+SSE2_TARGET static int32_t CountIntSse2(const int32_t* data, int32_t count, int32_t value) {
+	__m128i v = _mm_set1_epi32(value);
+	int32_t n = 0;
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i e = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), v);
+		n += std::popcount(uint32_t(_mm_movemask_ps(_mm_castsi128_ps(e))));
+	}
+	return n + CountScalar(data + i, count - i, value);
+}
+
+
+SSE2_TARGET static int32_t CountByteSse2(const uint8_t* data, int32_t count, uint8_t value) {
+	__m128i v = _mm_set1_epi8(char(value));
+	int32_t n = 0;
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i e = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), v);
+		n += std::popcount(uint32_t(_mm_movemask_epi8(e)));
+	}
+	return n + CountScalar(data + i, count - i, value);
+}
+
+
+SSE2_TARGET static float MinFloatSse2(const float* data, int32_t count) {
+	if (count < 4)
+		return MinScalar(data, count);
+	__m128 m = _mm_loadu_ps(data);
+	int32_t i = 4;
+	for (; i + 4 <= count; i += 4)
+		m = _mm_min_ps(m, _mm_loadu_ps(data + i));
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, m);
+	float result = MinScalar(lanes, 4);
+	return (i < count) ? std::min(result, MinScalar(data + i, count - i)) : result;
+}
+
+
+SSE2_TARGET static float MaxFloatSse2(const float* data, int32_t count) {
+	if (count < 4)
+		return MaxScalar(data, count);
+	__m128 m = _mm_loadu_ps(data);
+	int32_t i = 4;
+	for (; i + 4 <= count; i += 4)
+		m = _mm_max_ps(m, _mm_loadu_ps(data + i));
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, m);
+	float result = MaxScalar(lanes, 4);
+	return (i < count) ? std::max(result, MaxScalar(data + i, count - i)) : result;
+}
+
+
+// SSE2 has no 32 bit integer min and max; select by comparison instead
+SSE2_TARGET static int32_t MinIntSse2(const int32_t* data, int32_t count) {
+	if (count < 4)
+		return MinScalar(data, count);
+	__m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	int32_t i = 4;
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		__m128i greater = _mm_cmpgt_epi32(m, v);
+		m = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, m));
+	}
+	alignas(16) int32_t lanes[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), m);
+	int32_t result = MinScalar(lanes, 4);
+	return (i < count) ? std::min(result, MinScalar(data + i, count - i)) : result;
+}
+
+
+SSE2_TARGET static int32_t MaxIntSse2(const int32_t* data, int32_t count) {
+	if (count < 4)
+		return MaxScalar(data, count);
+	__m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	int32_t i = 4;
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		__m128i greater = _mm_cmpgt_epi32(v, m);
+		m = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, m));
+	}
+	alignas(16) int32_t lanes[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), m);
+	int32_t result = MaxScalar(lanes, 4);
+	return (i < count) ? std::max(result, MaxScalar(data + i, count - i)) : result;
+}
+
+
+SSE2_TARGET static uint8_t MinByteSse2(const uint8_t* data, int32_t count) {
+	if (count < 16)
+		return MinScalar(data, count);
+	__m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	int32_t i = 16;
+	for (; i + 16 <= count; i += 16)
+		m = _mm_min_epu8(m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+	alignas(16) uint8_t lanes[16];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), m);
+	uint8_t result = MinScalar(lanes, 16);
+	return (i < count) ? std::min(result, MinScalar(data + i, count - i)) : result;
+}
+
+
+SSE2_TARGET static uint8_t MaxByteSse2(const uint8_t* data, int32_t count) {
+	if (count < 16)
+		return MaxScalar(data, count);
+	__m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	int32_t i = 16;
+	for (; i + 16 <= count; i += 16)
+		m = _mm_max_epu8(m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+	alignas(16) uint8_t lanes[16];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), m);
+	uint8_t result = MaxScalar(lanes, 16);
+	return (i < count) ? std::max(result, MaxScalar(data + i, count - i)) : result;
+}
+
+
+SSE2_TARGET static float SumFloatSse2(const float* data, int32_t count) {
+	__m128 sum = _mm_setzero_ps();
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		sum = _mm_add_ps(sum, _mm_loadu_ps(data + i));
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, sum);
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + SumScalar<float>(data + i, count - i);
+}
+
+
+// the integers are sign extended to 64 bits by interleaving them with their sign masks
+SSE2_TARGET static int64_t SumIntSse2(const int32_t* data, int32_t count) {
+	__m128i sum = _mm_setzero_si128();
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		__m128i sign = _mm_srai_epi32(v, 31);
+		sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(v, sign));
+		sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(v, sign));
+	}
+	alignas(16) int64_t lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+	return lanes[0] + lanes[1] + SumScalar<int64_t>(data + i, count - i);
+}
+
+
+// the sum of absolute differences to zero adds up 8 bytes each into two 64 bit lanes
+SSE2_TARGET static uint64_t SumByteSse2(const uint8_t* data, int32_t count) {
+	__m128i sum = _mm_setzero_si128();
+	__m128i zero = _mm_setzero_si128();
+	int32_t i = 0;
+	for (; i + 16 <= count; i += 16)
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), zero));
+	alignas(16) uint64_t lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+	return lanes[0] + lanes[1] + SumScalar<uint64_t>(data + i, count - i);
+}
+
+
+SSE2_TARGET static void AddFloatSse2(float* dest, const float* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_loadu_ps(source + i)));
+	AddScalar(dest + i, source + i, count - i);
+}
+
+
+SSE2_TARGET static void AddIntSse2(int32_t* dest, const int32_t* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_add_epi32(d, s));
+	}
+	AddScalar(dest + i, source + i, count - i);
+}
+
+
+SSE2_TARGET static void MulFloatSse2(float* dest, const float* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(dest + i), _mm_loadu_ps(source + i)));
+	MulScalar(dest + i, source + i, count - i);
+}
+
+
+SSE2_TARGET static bool EqualSse2(const uint8_t* a, const uint8_t* b, size_t size) {
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i e = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+		if (_mm_movemask_epi8(e) != 0xFFFF)
+			return false;
+	}
+	return EqualScalar(a + i, b + i, size - i);
+}
+
+
+static const KernelTable sse2Kernels = {
+	Fill32Sse2,
+	FindFloatSse2, FindIntSse2, FindByteSse2,
+	CountFloatSse2, CountIntSse2, CountByteSse2,
+	MinFloatSse2, MinIntSse2, MinByteSse2,
+	MaxFloatSse2, MaxIntSse2, MaxByteSse2,
+	SumFloatSse2, SumIntSse2, SumByteSse2,
+	AddFloatSse2, AddIntSse2,
+	MulFloatSse2, MulScalar<int32_t>,
+	EqualSse2
+};
+
+// =================================================================================================
+// AVX2 kernels; 8 floats or integers or 32 bytes per step
+
+AVX2_TARGET static void Fill32Avx2(uint32_t* data, int32_t count, uint32_t value) {
+	__m256i v = _mm256_set1_epi32(int(value));
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), v);
+	FillScalar(data + i, count - i, value);
+}
+
+
+AVX2_TARGET static int32_t FindFloatAvx2(const float* data, int32_t count, float value) {
+	__m256 v = _mm256_set1_ps(value);
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		uint32_t mask = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), v, _CMP_EQ_OQ)));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+	int32_t j = FindScalar(data + i, count - i, value);
+	return (j < 0) ? -1 : i + j;
+}
+
+
+AVX2_TARGET static int32_t FindIntAvx2(const int32_t* data, int32_t count, int32_t value) {
+	__m256i v = _mm256_set1_epi32(value);
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i e = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), v);
+		uint32_t mask = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(e)));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+	int32_t j = FindScalar(data + i, count - i, value);
+	return (j < 0) ? -1 : i + j;
+}
+
+
+AVX2_TARGET static int32_t FindByteAvx2(const uint8_t* data, int32_t count, uint8_t value) {
+	__m256i v = _mm256_set1_epi8(char(value));
+	int32_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i e = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), v);
+		uint32_t mask = uint32_t(_mm256_movemask_epi8(e));
+		if (mask)
+			return i + std::countr_zero(mask);
+	}
+	int32_t j = FindScalar(data + i, count - i, value);
+	return (j < 0) ? -1 : i + j;
+}
+
+
+AVX2_TARGET static int32_t CountFloatAvx2(const float* data, int32_t count, float value) {
+	__m256 v = _mm256_set1_ps(value);
+	int32_t n = 0;
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		n += std::popcount(uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(data + i), v, _CMP_EQ_OQ))));
+	return n + CountScalar(data + i, count - i, value);
+}
+
+
+AVX2_TARGET static int32_t CountIntAvx2(const int32_t* data, int32_t count, int32_t value) {
+	__m256i v = _mm256_set1_epi32(value);
+	int32_t n = 0;
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i e = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), v);
+		n += std::popcount(uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(e))));
+	}
+	return n + CountScalar(data + i, count - i, value);
+}
+
+
+AVX2_TARGET static int32_t CountByteAvx2(const uint8_t* data, int32_t count, uint8_t value) {
+	__m256i v = _mm256_set1_epi8(char(value));
+	int32_t n = 0;
+	int32_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i e = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), v);
+		n += std::popcount(uint32_t(_mm256_movemask_epi8(e)));
+	}
+	return n + CountScalar(data + i, count - i, value);
+}
+
+
+AVX2_TARGET static float MinFloatAvx2(const float* data, int32_t count) {
+	if (count < 8)
+		return MinScalar(data, count);
+	__m256 m = _mm256_loadu_ps(data);
+	int32_t i = 8;
+	for (; i + 8 <= count; i += 8)
+		m = _mm256_min_ps(m, _mm256_loadu_ps(data + i));
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, m);
+	float result = MinScalar(lanes, 8);
+	return (i < count) ? std::min(result, MinScalar(data + i, count - i)) : result;
+}
+
+
+AVX2_TARGET static float MaxFloatAvx2(const float* data, int32_t count) {
+	if (count < 8)
+		return MaxScalar(data, count);
+	__m256 m = _mm256_loadu_ps(data);
+	int32_t i = 8;
+	for (; i + 8 <= count; i += 8)
+		m = _mm256_max_ps(m, _mm256_loadu_ps(data + i));
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, m);
+	float result = MaxScalar(lanes, 8);
+	return (i < count) ? std::max(result, MaxScalar(data + i, count - i)) : result;
+}
+
+
+AVX2_TARGET static int32_t MinIntAvx2(const int32_t* data, int32_t count) {
+	if (count < 8)
+		return MinScalar(data, count);
+	__m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+	int32_t i = 8;
+	for (; i + 8 <= count; i += 8)
+		m = _mm256_min_epi32(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+	alignas(32) int32_t lanes[8];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), m);
+	int32_t result = MinScalar(lanes, 8);
+	return (i < count) ? std::min(result, MinScalar(data + i, count - i)) : result;
+}
+
+
+AVX2_TARGET static int32_t MaxIntAvx2(const int32_t* data, int32_t count) {
+	if (count < 8)
+		return MaxScalar(data, count);
+	__m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+	int32_t i = 8;
+	for (; i + 8 <= count; i += 8)
+		m = _mm256_max_epi32(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+	alignas(32) int32_t lanes[8];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), m);
+	int32_t result = MaxScalar(lanes, 8);
+	return (i < count) ? std::max(result, MaxScalar(data + i, count - i)) : result;
+}
+
+
+AVX2_TARGET static uint8_t MinByteAvx2(const uint8_t* data, int32_t count) {
+	if (count < 32)
+		return MinScalar(data, count);
+	__m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+	int32_t i = 32;
+	for (; i + 32 <= count; i += 32)
+		m = _mm256_min_epu8(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+	alignas(32) uint8_t lanes[32];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), m);
+	uint8_t result = MinScalar(lanes, 32);
+	return (i < count) ? std::min(result, MinScalar(data + i, count - i)) : result;
+}
+
+
+AVX2_TARGET static uint8_t MaxByteAvx2(const uint8_t* data, int32_t count) {
+	if (count < 32)
+		return MaxScalar(data, count);
+	__m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+	int32_t i = 32;
+	for (; i + 32 <= count; i += 32)
+		m = _mm256_max_epu8(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+	alignas(32) uint8_t lanes[32];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), m);
+	uint8_t result = MaxScalar(lanes, 32);
+	return (i < count) ? std::max(result, MaxScalar(data + i, count - i)) : result;
+}
+
+
+AVX2_TARGET static float SumFloatAvx2(const float* data, int32_t count) {
+	__m256 sum = _mm256_setzero_ps();
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		sum = _mm256_add_ps(sum, _mm256_loadu_ps(data + i));
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, sum);
+	return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + SumScalar<float>(data + i, count - i);
+}
+
+
+AVX2_TARGET static int64_t SumIntAvx2(const int32_t* data, int32_t count) {
+	__m256i sum = _mm256_setzero_si256();
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+		sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+	}
+	alignas(32) int64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumScalar<int64_t>(data + i, count - i);
+}
+
+
+AVX2_TARGET static uint64_t SumByteAvx2(const uint8_t* data, int32_t count) {
+	__m256i sum = _mm256_setzero_si256();
+	__m256i zero = _mm256_setzero_si256();
+	int32_t i = 0;
+	for (; i + 32 <= count; i += 32)
+		sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), zero));
+	alignas(32) uint64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumScalar<uint64_t>(data + i, count - i);
+}
+
+
+AVX2_TARGET static void AddFloatAvx2(float* dest, const float* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_loadu_ps(dest + i), _mm256_loadu_ps(source + i)));
+	AddScalar(dest + i, source + i, count - i);
+}
+
+
+AVX2_TARGET static void AddIntAvx2(int32_t* dest, const int32_t* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + i));
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_add_epi32(d, s));
+	}
+	AddScalar(dest + i, source + i, count - i);
+}
+
+
+AVX2_TARGET static void MulFloatAvx2(float* dest, const float* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(dest + i), _mm256_loadu_ps(source + i)));
+	MulScalar(dest + i, source + i, count - i);
+}
+
+
+AVX2_TARGET static void MulIntAvx2(int32_t* dest, const int32_t* source, int32_t count) {
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + i));
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_mullo_epi32(d, s));
+	}
+	MulScalar(dest + i, source + i, count - i);
+}
+
+
+AVX2_TARGET static bool EqualAvx2(const uint8_t* a, const uint8_t* b, size_t size) {
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i e = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+		if (uint32_t(_mm256_movemask_epi8(e)) != 0xFFFFFFFFu)
+			return false;
+	}
+	return EqualScalar(a + i, b + i, size - i);
+}
+
+
+static const KernelTable avx2Kernels = {
+	Fill32Avx2,
+	FindFloatAvx2, FindIntAvx2, FindByteAvx2,
+	CountFloatAvx2, CountIntAvx2, CountByteAvx2,
+	MinFloatAvx2, MinIntAvx2, MinByteAvx2,
+	MaxFloatAvx2, MaxIntAvx2, MaxByteAvx2,
+	SumFloatAvx2, SumIntAvx2, SumByteAvx2,
+	AddFloatAvx2, AddIntAvx2,
+	MulFloatAvx2, MulIntAvx2,
+	EqualAvx2
+};
+
+#endif // SIMD_X86
+
+// =================================================================================================
+
+static SimdKernels::InstructionSet DetectInstructionSet(void) {
+#if SIMD_X86
+#	if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool hasSse2 = (info[3] & (1 << 26)) != 0;
+	// AVX registers must be enabled by the operating system (OSXSAVE, XCR0 bits 1 and 2)
+	bool hasAvx = ((info[2] & (1 << 27)) != 0) and ((info[2] & (1 << 28)) != 0) and ((_xgetbv(0) & 6) == 6);
+	bool hasAvx2 = false;
+	if (hasAvx and (maxLeaf >= 7)) {
+		__cpuidex(info, 7, 0);
+		hasAvx2 = (info[1] & (1 << 5)) != 0;
+	}
+#	else
+	__builtin_cpu_init();
+	bool hasSse2 = __builtin_cpu_supports("sse2");
+	bool hasAvx2 = __builtin_cpu_supports("avx2");
+#	endif
+	if (hasAvx2)
+		return SimdKernels::InstructionSet::AVX2;
+	if (hasSse2)
+		return SimdKernels::InstructionSet::SSE2;
+#endif
+	return SimdKernels::InstructionSet::Scalar;
+}
+
+
+static const KernelTable* SelectKernels(SimdKernels::InstructionSet instructionSet) {
+#if SIMD_X86
+	if (instructionSet == SimdKernels::InstructionSet::AVX2)
+		return &avx2Kernels;
+	if (instructionSet == SimdKernels::InstructionSet::SSE2)
+		return &sse2Kernels;
+#endif
+	return &scalarKernels;
+}
+
+
+static SimdKernels::InstructionSet SupportedInstructionSet(void) {
+	static const SimdKernels::InstructionSet supported = DetectInstructionSet();
+	return supported;
+}
+
+
+// constant initialized, so kernels called from other static initializers find it valid
+static std::atomic<int> selectedInstructionSet(-1);
+
+static std::atomic<const KernelTable*> kernels(nullptr);
+
+
+static const KernelTable& Kernels(void) {
+	const KernelTable* table = kernels.load(std::memory_order_acquire);
+	if (not table) {
+		// a concurrent SetInstructionSet wins
+		const KernelTable* selected = SelectKernels(SupportedInstructionSet());
+		table = kernels.compare_exchange_strong(table, selected, std::memory_order_acq_rel) ? selected : table;
+	}
+	return *table;
+}
+
+// =================================================================================================
+
+SimdKernels::InstructionSet SimdKernels::GetInstructionSet(void) {
+	int selected = selectedInstructionSet.load(std::memory_order_acquire);
+	return (selected < 0) ? SupportedInstructionSet() : InstructionSet(selected);
+}
+
+
+void SimdKernels::SetInstructionSet(InstructionSet requested) {
+	if (requested > SupportedInstructionSet())
+		requested = SupportedInstructionSet();
+	selectedInstructionSet.store(int(requested), std::memory_order_release);
+	kernels.store(SelectKernels(requested), std::memory_order_release);
+}
+
+
+const char* SimdKernels::InstructionSetName(void) {
+	switch (GetInstructionSet()) {
+		case InstructionSet::AVX2:
+			return "AVX2";
+		case InstructionSet::SSE2:
+			return "SSE2";
+		default:
+			return "scalar";
+	}
+}
+
+
+void SimdKernels::Fill(float* data, int32_t count, float value) {
+	Kernels().fill32(reinterpret_cast<uint32_t*>(data), count, std::bit_cast<uint32_t>(value));
+}
+
+void SimdKernels::Fill(int32_t* data, int32_t count, int32_t value) {
+	Kernels().fill32(reinterpret_cast<uint32_t*>(data), count, uint32_t(value));
+}
+
+void SimdKernels::Fill(uint32_t* data, int32_t count, uint32_t value) {
+	Kernels().fill32(data, count, value);
+}
+
+// memset is vectorized by the C runtime already
+void SimdKernels::Fill(uint8_t* data, int32_t count, uint8_t value) {
+	if (count > 0)
+		memset(data, value, size_t(count));
+}
+
+
+int32_t SimdKernels::Find(const float* data, int32_t count, float value) {
+	return Kernels().findFloat(data, count, value);
+}
+
+int32_t SimdKernels::Find(const int32_t* data, int32_t count, int32_t value) {
+	return Kernels().findInt(data, count, value);
+}
+
+int32_t SimdKernels::Find(const uint8_t* data, int32_t count, uint8_t value) {
+	return Kernels().findByte(data, count, value);
+}
+
+
+int32_t SimdKernels::Count(const float* data, int32_t count, float value) {
+	return Kernels().countFloat(data, count, value);
+}
+
+int32_t SimdKernels::Count(const int32_t* data, int32_t count, int32_t value) {
+	return Kernels().countInt(data, count, value);
+}
+
+int32_t SimdKernels::Count(const uint8_t* data, int32_t count, uint8_t value) {
+	return Kernels().countByte(data, count, value);
+}
+
+
+float SimdKernels::Min(const float* data, int32_t count) {
+	return Kernels().minFloat(data, count);
+}
+
+int32_t SimdKernels::Min(const int32_t* data, int32_t count) {
+	return Kernels().minInt(data, count);
+}
+
+uint8_t SimdKernels::Min(const uint8_t* data, int32_t count) {
+	return Kernels().minByte(data, count);
+}
+
+
+float SimdKernels::Max(const float* data, int32_t count) {
+	return Kernels().maxFloat(data, count);
+}
+
+int32_t SimdKernels::Max(const int32_t* data, int32_t count) {
+	return Kernels().maxInt(data, count);
+}
+
+uint8_t SimdKernels::Max(const uint8_t* data, int32_t count) {
+	return Kernels().maxByte(data, count);
+}
+
+
+float SimdKernels::Sum(const float* data, int32_t count) {
+	return Kernels().sumFloat(data, count);
+}
+
+int64_t SimdKernels::Sum(const int32_t* data, int32_t count) {
+	return Kernels().sumInt(data, count);
+}
+
+uint64_t SimdKernels::Sum(const uint8_t* data, int32_t count) {
+	return Kernels().sumByte(data, count);
+}
+
+
+void SimdKernels::Add(float* dest, const float* source, int32_t count) {
+	Kernels().addFloat(dest, source, count);
+}
+
+void SimdKernels::Add(int32_t* dest, const int32_t* source, int32_t count) {
+	Kernels().addInt(dest, source, count);
+}
+
+
+void SimdKernels::Mul(float* dest, const float* source, int32_t count) {
+	Kernels().mulFloat(dest, source, count);
+}
+
+void SimdKernels::Mul(int32_t* dest, const int32_t* source, int32_t count) {
+	Kernels().mulInt(dest, source, count);
+}
+
+
+bool SimdKernels::Equal(const void* a, const void* b, size_t size) {
+	return Kernels().equal(reinterpret_cast<const uint8_t*>(a), reinterpret_cast<const uint8_t*>(b), size);
+}
+
+// =================================================================================================
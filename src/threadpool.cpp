@@ -0,0 +1,98 @@
+#define NOMINMAX
+
+#include "threadpool.h"
+
+#include <algorithm>
+
+// =================================================================================================
+
+thread_local bool ThreadPool::m_isRunningTasks = false;
+
+
+ThreadPool::ThreadPool(int32_t workerCount) {
+	if (workerCount < 0)
+		workerCount = std::max(int32_t(std::thread::hardware_concurrency()) - 1, 0);
+	m_workers = std::make_unique<std::thread[]>(size_t(workerCount));
+	for (int32_t i = 0; i < workerCount; i++) {
+		m_workers[i] = std::thread(&ThreadPool::Work, this);
+		m_workerCount = i + 1;
+	}
+}
+
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (int32_t i = 0; i < m_workerCount; i++)
+		m_workers[i].join();
+}
+
+
+void ThreadPool::ParallelFor(int32_t count, const Task& task) {
+	if (count <= 0)
+		return;
+	// a nested loop must not wait for the pool it is running on; the thread may even hold m_loopLock
+	if ((count == 1) or (m_workerCount == 0) or m_isRunningTasks or not m_loopLock.try_lock()) {
+		for (int32_t i = 0; i < count; i++)
+			task(i);
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		// a worker that woke up too late for the previous loop may still be looking at it
+		m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+		m_task = &task;
+		m_count = count;
+		m_next.store(0, std::memory_order_relaxed);
+		m_finished = 0;
+		++m_generation;
+	}
+	m_wake.notify_all();
+	int32_t finished = RunTasks();
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_finished += finished;
+		m_done.wait(lock, [this] { return m_finished == m_count; });
+	}
+	m_loopLock.unlock();
+}
+
+
+void ThreadPool::Work(void) {
+	uint64_t generation = 0;
+	std::unique_lock<std::mutex> lock(m_lock);
+	for (;;) {
+		m_wake.wait(lock, [&] { return m_stop or (m_generation != generation); });
+		if (m_stop)
+			return;
+		generation = m_generation;
+		++m_busyWorkers;
+		lock.unlock();
+		int32_t finished = RunTasks();
+		lock.lock();
+		m_finished += finished;
+		--m_busyWorkers;
+		if ((m_finished == m_count) or (m_busyWorkers == 0))
+			m_done.notify_all();
+	}
+}
+
+
+int32_t ThreadPool::RunTasks(void) {
+	int32_t finished = 0;
+	m_isRunningTasks = true;
+	for (;;) {
+		int32_t i = m_next.fetch_add(1, std::memory_order_relaxed);
+		if (i >= m_count)
+			break;
+		(*m_task)(i);
+		++finished;
+	}
+	m_isRunningTasks = false;
+	return finished;
+}
+
+// =================================================================================================